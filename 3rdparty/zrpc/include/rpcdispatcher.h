@@ -10,6 +10,7 @@
 #include <google/protobuf/descriptor.h>
 #include <map>
 #include <memory>
+#include <unordered_map>
 
 #include "abstractdispatcher.h"
 #include "specdata.h"
@@ -36,6 +37,16 @@ public:
     // all services should be registerd on there before progress start
     // key: service_name
     std::map<std::string, service_ptr> m_service_map;
+
+private:
+    struct MethodEntry {
+        service_ptr service;
+        const google::protobuf::MethodDescriptor *method{nullptr};
+    };
+
+    // methods resolved once at registration
+    // key: service_full_name, like QueryService.query_name
+    std::unordered_map<std::string, MethodEntry> m_method_map;
 };
 
 } // namespace zrpc
@@ -11,9 +11,14 @@
 #include <functional>
 #include "rpcchannel.h"
 #include "rpccontroller.h"
+#include "zrpc_defines.h"
 
 namespace zrpc_ns {
 
+// Congestion control of the zrpc connections opened from now on, like "bbr".
+// Linux only, a name the kernel refuses keeps the default one.
+ZRPC_API void setCongestionControl(const char *name);
+
 class ZRPC_API ZRpcClient {
 
 public:
@@ -46,6 +51,15 @@ public:
     void setCallBackFunc(const std::function<void(int, const fastring &, const uint16)> &call);
 
     bool checkConnected();
+
+    // Let up to count requests of one connection run concurrently, replies may then
+    // come out of order. Only for services whose handlers are independent, default 1.
+    void setMaxInflight(int count);
+
+    // Connections accepted from one remote peer ip at the same time, default 64.
+    // Loopback peers are not limited.
+    void setMaxPeerConnections(int count);
+    ConnectionStats stats();
 private:
     bool doregister(std::shared_ptr<google::protobuf::Service> service);
 
@@ -15,4 +15,21 @@
     #define ZRPC_API
 #endif
 
+namespace zrpc_ns {
+
+// counters of a server's connections
+struct ConnectionStats
+{
+    long long active { 0 };
+    long long accepted { 0 };
+    long long closed { 0 };
+    long long rejected { 0 };
+    // capacity of the in and out buffers of the active connections
+    long long buffer_bytes { 0 };
+    // buffers released back to their initial size after a burst
+    long long buffer_shrinks { 0 };
+};
+
+} // namespace zrpc_ns
+
 #endif // ZRPC_DEFINES_H
@@ -13,6 +13,12 @@
 #include "co/log.h"
 #include "co/fastring.h"
 
+namespace google {
+namespace protobuf {
+class MessageLite;
+} // namespace protobuf
+} // namespace google
+
 namespace zrpc_ns {
 
 class SpecDataStruct : public AbstractData {
@@ -43,6 +49,9 @@ public:
                           // will display details of reason why call rpc failed. it only be seted by
                           // RpcController
     std::string pb_data;  // business pb data
+    const google::protobuf::MessageLite *pb_message{nullptr}; // if set, it is serialized straight
+                                                              // into the output buffer instead of
+                                                              // pb_data, only valid until encoded
     int32_t check_num{-1}; // check_num of all package. to check legality of data
     // char end;                        // identify end of a spec data protocal data
 };
@@ -0,0 +1,210 @@
+﻿// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "socktuner.h"
+#include "co/atomic.h"
+#include "co/log.h"
+#include "co/co.h"
+#include "co/error.h"
+#include "co/time.h"
+
+#ifdef __linux__
+#include <stdio.h>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+namespace zrpc_ns {
+
+#ifdef __linux__
+// unsent data kept in the kernel, so a control message is not queued behind seconds of file data
+static const int kNotSentLowat = 128 * 1024;
+// throughput is measured over this interval before the buffers are reconsidered
+static const int64 kAdaptInterval = 1000;
+static const int kMinBuffer = 256 * 1024;
+static const int kMaxBuffer = 16 * 1024 * 1024;
+
+static std::mutex g_congestion_mutex;
+static fastring g_congestion;
+
+// field-th number of a sysctl file, like the max of "4096 16384 4194304"
+static int sysctlValue(const char *path, int field, int def)
+{
+    int v = def;
+    FILE *f = fopen(path, "r");
+    if (f) {
+        for (int i = 0; i <= field; ++i) {
+            if (fscanf(f, "%d", &v) != 1) {
+                v = def;
+                break;
+            }
+        }
+        fclose(f);
+    }
+    return v;
+}
+
+// with the default net.core.{w,r}mem_max (208K) setting the option can only
+// shrink a buffer below the autotune ceiling, so the tuning stays off then
+static bool canRaise(const char *name, int max, int ceiling)
+{
+    if (max * 2 > ceiling)
+        return true;
+    LOG << name << " tuning inactive, mem_max " << max << " is below the autotune ceiling " << ceiling;
+    return false;
+}
+#endif
+
+void SockTuner::setCongestion(const fastring &name)
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lk(g_congestion_mutex);
+    g_congestion = name;
+#else
+    (void)name;
+#endif
+}
+
+void SockTuner::attach(int fd)
+{
+#ifdef __linux__
+    if (fd < 0 || fd == m_fd)
+        return;
+
+    m_fd = fd;
+    atomic_store(&m_recv_bytes, 0);
+    atomic_store(&m_sent_bytes, 0);
+    atomic_store(&m_window_start, co::now::ms());
+
+#ifdef TCP_NOTSENT_LOWAT
+    int lowat = kNotSentLowat;
+    co::setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, sizeof(lowat));
+#endif
+
+#ifdef TCP_CONGESTION
+    fastring congestion;
+    {
+        std::lock_guard<std::mutex> lk(g_congestion_mutex);
+        congestion = g_congestion;
+    }
+    if (!congestion.empty()
+        && co::setsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, congestion.data(),
+                          static_cast<int>(congestion.size())) != 0) {
+        // the module may not be loaded or allowed, stay on the default one
+        WLOG << "set congestion control " << congestion << " failed: " << co::strerror();
+    }
+#endif
+
+    int len = sizeof(m_sndbuf);
+    co::getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &m_sndbuf, &len);
+    len = sizeof(m_rcvbuf);
+    co::getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &m_rcvbuf, &len);
+#else
+    (void)fd;
+#endif
+}
+
+void SockTuner::received(int64 bytes)
+{
+    transferred(&m_recv_bytes, bytes);
+}
+
+void SockTuner::sent(int64 bytes)
+{
+    transferred(&m_sent_bytes, bytes);
+}
+
+void SockTuner::transferred(int64 *counter, int64 bytes)
+{
+#ifdef __linux__
+    if (m_fd < 0 || bytes <= 0)
+        return;
+
+    atomic_add(counter, bytes);
+    int64 start = atomic_load(&m_window_start);
+    int64 now = co::now::ms();
+    if (now - start < kAdaptInterval)
+        return;
+
+    // only one of the reading and writing coroutines takes the window
+    if (atomic_cas(&m_window_start, start, now) != start)
+        return;
+
+    adapt(now - start);
+#else
+    (void)counter;
+    (void)bytes;
+#endif
+}
+
+void SockTuner::adapt(int64 elapsed_ms)
+{
+#ifdef __linux__
+    // each direction is sized by its own rate
+    int64 recv_rate = atomic_swap(&m_recv_bytes, 0) * 1000 / elapsed_ms;
+    int64 sent_rate = atomic_swap(&m_sent_bytes, 0) * 1000 / elapsed_ms;
+
+    struct tcp_info info;
+    int len = sizeof(info);
+    if (co::getsockopt(m_fd, IPPROTO_TCP, TCP_INFO, &info, &len) != 0 || info.tcpi_rtt == 0)
+        return;
+
+    raiseBuffer(SO_SNDBUF, sent_rate, static_cast<int>(info.tcpi_rtt), &m_sndbuf);
+    raiseBuffer(SO_RCVBUF, recv_rate, static_cast<int>(info.tcpi_rtt), &m_rcvbuf);
+#else
+    (void)elapsed_ms;
+#endif
+}
+
+void SockTuner::raiseBuffer(int opt, int64 rate, int rtt_us, int *current)
+{
+#ifdef __linux__
+    // setting the option locks the buffer and turns autotuning off for it,
+    // so it is only done when autotuning can not reach the size anyway
+    static const int wmem_auto = sysctlValue("/proc/sys/net/ipv4/tcp_wmem", 2, 4194304);
+    static const int rmem_auto = sysctlValue("/proc/sys/net/ipv4/tcp_rmem", 2, 6291456);
+    static const int wmem_max = sysctlValue("/proc/sys/net/core/wmem_max", 0, 212992);
+    static const int rmem_max = sysctlValue("/proc/sys/net/core/rmem_max", 0, 212992);
+    static const bool snd_tunable = canRaise("SO_SNDBUF", wmem_max, wmem_auto);
+    static const bool rcv_tunable = canRaise("SO_RCVBUF", rmem_max, rmem_auto);
+    if (!(opt == SO_SNDBUF ? snd_tunable : rcv_tunable))
+        return;
+
+    // bandwidth-delay product of what was really moved, twice for headroom
+    int64 want = rate * rtt_us / 1000000 * 2;
+    if (want < kMinBuffer)
+        return;
+    if (want > kMaxBuffer)
+        want = kMaxBuffer;
+
+    int ceiling = opt == SO_SNDBUF ? wmem_auto : rmem_auto;
+    if (want <= ceiling)
+        return;
+
+    // the kernel doubles the value for its bookkeeping and clamps it to the
+    // sysctl, a value below the autotune ceiling would shrink the buffer
+    int limit = opt == SO_SNDBUF ? wmem_max : rmem_max;
+    int value = want / 2 > limit ? limit : static_cast<int>(want / 2);
+    if (value * 2 <= ceiling)
+        return;
+
+    int len = sizeof(*current);
+    co::getsockopt(m_fd, SOL_SOCKET, opt, current, &len);
+    if (value * 2 <= *current)
+        return;
+
+    if (co::setsockopt(m_fd, SOL_SOCKET, opt, &value, sizeof(value)) == 0) {
+        co::getsockopt(m_fd, SOL_SOCKET, opt, current, &len);
+        DLOG << (opt == SO_SNDBUF ? "SO_SNDBUF" : "SO_RCVBUF") << " raised to " << *current;
+    }
+#else
+    (void)opt;
+    (void)rate;
+    (void)rtt_us;
+    (void)current;
+#endif
+}
+
+} // namespace zrpc_ns
@@ -0,0 +1,44 @@
+﻿// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ZRPC_SOCKTUNER_H
+#define ZRPC_SOCKTUNER_H
+
+#include "co/fastring.h"
+#include "co/def.h"
+
+namespace zrpc_ns {
+
+// Socket options of one connection. The kernel autotunes the buffers up to
+// net.ipv4.tcp_{w,r}mem, a buffer is only set when the measured rtt * throughput
+// of its direction goes beyond that, so bulk transfers on links with a large
+// delay are not limited by the window. Linux only, no-op elsewhere.
+class SockTuner {
+public:
+    // congestion control for new connections, like "bbr", empty keeps the kernel default
+    static void setCongestion(const fastring &name);
+
+    // apply the options once the socket is connected, again if fd changes
+    void attach(int fd);
+
+    // bytes received or sent on the socket
+    void received(int64 bytes);
+    void sent(int64 bytes);
+
+private:
+    void transferred(int64 *counter, int64 bytes);
+    void adapt(int64 elapsed_ms);
+    void raiseBuffer(int opt, int64 rate, int rtt_us, int *current);
+
+    int m_fd{-1};
+    int m_sndbuf{0};
+    int m_rcvbuf{0};
+    int64 m_recv_bytes{0};
+    int64 m_sent_bytes{0};
+    int64 m_window_start{0};
+};
+
+} // namespace zrpc_ns
+
+#endif
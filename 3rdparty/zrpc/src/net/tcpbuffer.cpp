@@ -6,14 +6,35 @@
 #include <string.h>
 #include "tcpbuffer.h"
 #include "co/log.h"
+#include "co/atomic.h"
 
 namespace zrpc_ns {
 
 TcpBuffer::TcpBuffer(int size) {
+    m_size = size;
     m_buffer.resize(size);
 }
 
 TcpBuffer::~TcpBuffer() {
+    if (m_mem_counter)
+        atomic_sub(m_mem_counter, m_tracked, mo_relaxed);
+}
+
+void TcpBuffer::setMemoryCounter(long long *counter, long long *shrinks) {
+    if (m_mem_counter)
+        atomic_sub(m_mem_counter, m_tracked, mo_relaxed);
+    m_mem_counter = counter;
+    m_shrink_counter = shrinks;
+    m_tracked = 0;
+    trackCapacity();
+}
+
+void TcpBuffer::trackCapacity() {
+    long long cap = static_cast<long long>(m_buffer.capacity());
+    if (!m_mem_counter || cap == m_tracked)
+        return;
+    atomic_add(m_mem_counter, cap - m_tracked, mo_relaxed);
+    m_tracked = cap;
 }
 
 int TcpBuffer::readAble() {
@@ -43,13 +64,18 @@ void TcpBuffer::resizeBuffer(int size) {
     m_buffer.swap(tmp);
     m_read_index = 0;
     m_write_index = m_read_index + c;
+    trackCapacity();
 }
 
-void TcpBuffer::writeToBuffer(const char *buf, int size) {
+void TcpBuffer::ensureWriteAble(int size) {
     if (size > writeAble()) {
         int new_size = (int)(1.5 * (m_write_index + size));
         resizeBuffer(new_size);
     }
+}
+
+void TcpBuffer::writeToBuffer(const char *buf, int size) {
+    ensureWriteAble(size);
     memcpy(&m_buffer[m_write_index], buf, size);
     m_write_index += size;
 }
@@ -82,6 +108,7 @@ void TcpBuffer::adjustBuffer() {
         m_write_index = count;
         m_read_index = 0;
         new_buffer.clear();
+        trackCapacity();
     }
 }
 
@@ -90,7 +117,16 @@ int TcpBuffer::getSize() {
 }
 
 void TcpBuffer::clearBuffer() {
-    m_buffer.clear();
+    // give back the memory of a burst once everything was consumed,
+    // keep the usual size around
+    if (readAble() == 0 && m_buffer.capacity() > static_cast<size_t>(m_size) * 4) {
+        std::vector<char>(static_cast<size_t>(m_size)).swap(m_buffer);
+        trackCapacity();
+        if (m_shrink_counter)
+            atomic_inc(m_shrink_counter, mo_relaxed);
+    } else {
+        m_buffer.clear();
+    }
     m_read_index = 0;
     m_write_index = 0;
 }
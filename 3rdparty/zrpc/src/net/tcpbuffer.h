@@ -33,6 +33,9 @@ public:
 
     void writeToBuffer(const char *buf, int size);
 
+    // grow the buffer so that size bytes can be written at writeIndex()
+    void ensureWriteAble(int size);
+
     void readFromBuffer(std::vector<char> &re, int size);
 
     void resizeBuffer(int size);
@@ -53,10 +56,20 @@ public:
 
     void adjustBuffer();
 
+    // count the capacity of the buffer into *counter while it lives,
+    // and each shrink after a burst into *shrinks
+    void setMemoryCounter(long long *counter, long long *shrinks = nullptr);
+
+private:
+    void trackCapacity();
+
 private:
     int m_read_index{0};
     int m_write_index{0};
     int m_size{0};
+    long long *m_mem_counter{nullptr};
+    long long *m_shrink_counter{nullptr};
+    long long m_tracked{0};
 
 public:
     std::vector<char> m_buffer;
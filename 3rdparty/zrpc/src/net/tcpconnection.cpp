@@ -26,8 +26,11 @@ TcpConnection::TcpConnection(TcpServer *tcp_svr,
 
     m_codec = m_tcp_svr->getCodec();
     initBuffer(buff_size);
+    m_read_buffer->setMemoryCounter(m_tcp_svr->bufferBytes(), m_tcp_svr->bufferShrinks());
+    m_write_buffer->setMemoryCounter(m_tcp_svr->bufferBytes(), m_tcp_svr->bufferShrinks());
     m_state = Connected;
     remoteIP = getRemoteIp();
+    m_tuner.attach(m_serv_conn->socket());
     // DLOG << "succ create tcp connection[" << m_state << "]";
 }
 
@@ -72,6 +75,8 @@ bool TcpConnection::waited()
 void TcpConnection::setUpClient()
 {
     setState(Connected);
+    // the client may have reconnected with a new socket
+    m_tuner.attach(m_cli_conn->socket());
 }
 
 TcpConnection::~TcpConnection()
@@ -117,6 +122,8 @@ int64 TcpConnection::read_hook(char *buf, int len)
         }
     }
 
+    if (r > 0)
+        m_tuner.received(r);
     return r;
 }
 
@@ -137,6 +144,8 @@ int64 TcpConnection::write_hook(const void *buf, int count)
         }
     }
 
+    if (r > 0)
+        m_tuner.sent(r);
     return r;
 }
 
@@ -155,8 +164,12 @@ void TcpConnection::MainServerLoopCorFunc()
 
         execute();
 
+        co::mutex_guard g(m_write_mutex);
         output();
     }
+
+    // the connection object is gone once this returns, wait for running requests
+    m_inflight.wait();
     // LOG << "this connection has already end loop";
 }
 
@@ -249,7 +262,7 @@ void TcpConnection::execute()
         }
 
         if (m_connection_type == ServerConnection) {
-            m_tcp_svr->getDispatcher()->dispatch(data.get(), this);
+            dispatchRequest(data);
         } else if (m_connection_type == ClientConnection) {
             std::shared_ptr<SpecDataStruct> tmp = std::dynamic_pointer_cast<SpecDataStruct>(data);
             if (tmp) {
@@ -261,6 +274,35 @@ void TcpConnection::execute()
     m_read_buffer->clearBuffer();
 }
 
+void TcpConnection::dispatchRequest(const std::shared_ptr<AbstractData> &data)
+{
+    // Sequential by default; above the limit the request runs here, which also stops reading
+    int limit = m_tcp_svr->maxInflight();
+    if (limit <= 1 || atomic_load(&m_inflight_count) >= limit) {
+        m_tcp_svr->getDispatcher()->dispatch(data.get(), this);
+        return;
+    }
+
+    atomic_inc(&m_inflight_count);
+    m_inflight.add();
+    auto self = shared_from_this();
+    go([self, data]() {
+        self->m_tcp_svr->getDispatcher()->dispatch(data.get(), self.get());
+        atomic_dec(&self->m_inflight_count);
+        self->m_inflight.done();
+    });
+}
+
+void TcpConnection::reply(AbstractData *data)
+{
+    co::mutex_guard g(m_write_mutex);
+    m_codec->encode(m_write_buffer.get(), data);
+
+    // concurrent replies are written as soon as they are ready
+    if (m_tcp_svr && m_tcp_svr->maxInflight() > 1)
+        output();
+}
+
 void TcpConnection::output()
 {
     while (true) {
@@ -11,10 +11,12 @@
 #include <map>
 #include "co/log.h"
 #include "co/tcp.h"
+#include "co/co.h"
 
 #include "tcpbuffer.h"
 #include "specodec.h"
 #include "netaddress.h"
+#include "socktuner.h"
 
 using CallBackFunc = std::function<void(int, const fastring &, const uint16)>;
 namespace zrpc_ns {
@@ -76,7 +78,11 @@ public:
 
     bool getResPackageData(const std::string &msg_req, SpecDataStruct::pb_ptr &pb_struct);
 
+    // encode a reply of a dispatched request, replies are matched by msg_req on the client
+    void reply(AbstractData *data);
+
     fastring getRemoteIp();
+    const fastring &peerIp() const { return remoteIP; }
 
 public:
     void MainServerLoopCorFunc();
@@ -95,6 +101,7 @@ private:
     int64 read_hook(char *buf, int len);
     int64 write_hook(const void *buf, int count);
     void clearClient();
+    void dispatchRequest(const std::shared_ptr<AbstractData> &data);
 
 private:
     TcpServer *m_tcp_svr { nullptr };
@@ -122,6 +129,14 @@ private:
 
     CallBackFunc callback { nullptr };
     int64 _rev_start_time = 0;
+
+    // serializes writes, replies may come from several dispatch coroutines
+    co::mutex m_write_mutex;
+    // requests dispatched to their own coroutine and not replied yet
+    co::wait_group m_inflight;
+    int m_inflight_count { 0 };
+
+    SockTuner m_tuner;
 };
 
 }   // namespace zrpc_ns
@@ -54,8 +54,13 @@ TcpServer::~TcpServer() {
 
 void TcpServer::on_connection_cb(tcp::Connection conn) {
     // DLOG << "on_connection_cb go";
+    int fd = conn.socket();
     TcpConnection::ptr tconn = addClient(&conn);
+    if (!tconn)
+        return;   // conn is closed when it goes out of scope
+
     tconn->initServer();
+    removeClient(fd, tconn);
 }
 
 bool TcpServer::registerService(std::shared_ptr<google::protobuf::Service> service) {
@@ -77,6 +82,7 @@ void TcpServer::setCallBackFunc(const CallBackFunc &callback)
 
 bool TcpServer::checkConnected()
 {
+    co::mutex_guard g(m_clients_mutex);
     for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
         if (!it->second)
             continue;
@@ -86,28 +92,73 @@ bool TcpServer::checkConnected()
     return false;
 }
 
+static bool isLoopback(const fastring &ip) {
+    return ip.starts_with("127.") || ip == "::1" || ip.starts_with("::ffff:127.");
+}
+
 TcpConnection::ptr TcpServer::addClient(tcp::Connection *conntion) {
     int fd = conntion->socket();
-    auto it = m_clients.find(fd);
-    if (it != m_clients.end()) {
-        it->second.reset();
-        // set new Tcpconnection
-        // DLOG << "fd " << fd << " have exist, reset it" << m_addr->toString();
-        it->second = std::make_shared<TcpConnection>(this, conntion, PERPKG_MAX_LEN, getPeerAddr());
-        if (callback)
-            it->second->setCallBack(callback);
-        return it->second;
-    } else {
-        // DLOG << "fd " << fd << " did't exist, new it" << m_addr->toString();
-        TcpConnection::ptr conn = std::make_shared<TcpConnection>(this,
-                                                                  conntion,
-                                                                  PERPKG_MAX_LEN,
-                                                                  getPeerAddr());
-        if (callback)
-            conn->setCallBack(callback);
-        m_clients.insert(std::make_pair(fd, conn));
-        return conn;
+    TcpConnection::ptr conn = std::make_shared<TcpConnection>(this,
+                                                              conntion,
+                                                              PERPKG_MAX_LEN,
+                                                              getPeerAddr());
+    const fastring &ip = conn->peerIp();
+
+    co::mutex_guard g(m_clients_mutex);
+    if (!isLoopback(ip) && m_peer_counts[ip] >= m_max_peer_connections) {
+        ++m_stats.rejected;
+        ELOG << "too many connections from " << ip << ", reject it";
+        return nullptr;
     }
+    ++m_peer_counts[ip];
+    ++m_stats.accepted;
+    ++m_stats.active;
+
+    if (callback)
+        conn->setCallBack(callback);
+
+    // an fd still in the map belongs to a connection whose loop is ending
+    m_clients[fd] = conn;
+    return conn;
+}
+
+void TcpServer::removeClient(int fd, const TcpConnection::ptr &conn) {
+    // the socket is closed now, use the address taken when it was accepted
+    const fastring &ip = conn->peerIp();
+
+    co::mutex_guard g(m_clients_mutex);
+    auto peer = m_peer_counts.find(ip);
+    if (peer != m_peer_counts.end() && --peer->second <= 0)
+        m_peer_counts.erase(peer);
+    ++m_stats.closed;
+    --m_stats.active;
+
+    // the fd may already be reused by a newer connection
+    auto it = m_clients.find(fd);
+    if (it != m_clients.end() && it->second == conn)
+        m_clients.erase(it);
+}
+
+void TcpServer::setMaxPeerConnections(int count) {
+    m_max_peer_connections = count < 1 ? 1 : count;
+}
+
+ConnectionStats TcpServer::stats() {
+    co::mutex_guard g(m_clients_mutex);
+    ConnectionStats stats = m_stats;
+    stats.buffer_bytes = atomic_load(&m_buffer_bytes, mo_relaxed);
+    stats.buffer_shrinks = atomic_load(&m_buffer_shrinks, mo_relaxed);
+    return stats;
+}
+
+void TcpServer::setMaxInflight(int count)
+{
+    m_max_inflight = count < 1 ? 1 : count;
+}
+
+int TcpServer::maxInflight() const
+{
+    return m_max_inflight;
 }
 
 NetAddress::ptr TcpServer::getPeerAddr() {
@@ -38,6 +38,18 @@ public:
 
     bool checkConnected();
 
+    // requests of one connection that may run at the same time, 1 keeps them in order
+    void setMaxInflight(int count);
+    int maxInflight() const;
+
+    // connections accepted from one remote peer ip at the same time, the rest
+    // are closed; loopback peers (local ipc) are not limited
+    void setMaxPeerConnections(int count);
+    ConnectionStats stats();
+    // buffer capacity of the connections is summed up here
+    long long *bufferBytes() { return &m_buffer_bytes; }
+    long long *bufferShrinks() { return &m_buffer_shrinks; }
+
 public:
     AbstractDispatcher::ptr getDispatcher();
 
@@ -49,6 +61,7 @@ public:
 
 private:
     TcpConnection::ptr addClient(tcp::Connection *conntion);
+    void removeClient(int fd, const TcpConnection::ptr &conn);
 
 private:
     tcp::Server _tcp_serv;
@@ -66,9 +79,18 @@ private:
 
     AbstractCodeC::ptr m_codec;
 
+    // live connections only, an entry is removed when its loop ends
     std::map<int, std::shared_ptr<TcpConnection>> m_clients;
+    std::map<fastring, int> m_peer_counts;
+    co::mutex m_clients_mutex;
+    int m_max_peer_connections { 64 };
+    ConnectionStats m_stats;
+    long long m_buffer_bytes { 0 };
+    long long m_buffer_shrinks { 0 };
 
     CallBackFunc callback { nullptr };
+
+    int m_max_inflight { 1 };
 };
 
 } // namespace zrpc_ns
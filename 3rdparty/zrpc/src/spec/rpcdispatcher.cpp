@@ -5,6 +5,7 @@
 #include <google/protobuf/message.h>
 #include <google/protobuf/service.h>
 #include <google/protobuf/descriptor.h>
+#include <google/protobuf/arena.h>
 #include <sstream>
 
 #include "abstractdispatcher.h"
@@ -40,46 +41,56 @@ void ZRpcDispacther::dispatch(AbstractData *data, TcpConnection *conn) {
         reply_pk.msg_req = Util::genMsgNumber();
     }
 
-    if (!parseServiceFullName(tmp->service_full_name, service_name, method_name)) {
-        ELOG << reply_pk.msg_req << "|parse service name " << tmp->service_full_name << "error";
+    service_ptr service;
+    const google::protobuf::MethodDescriptor *method = nullptr;
 
-        reply_pk.err_code = ERROR_PARSE_SERVICE_NAME;
-        std::stringstream ss;
-        ss << "cannot parse service_name:[" << tmp->service_full_name << "]";
-        reply_pk.err_info = ss.str();
-        conn->getCodec()->encode(conn->getOutBuffer(), dynamic_cast<AbstractData *>(&reply_pk));
-        return;
-    }
-
-    auto it = m_service_map.find(service_name);
-    if (it == m_service_map.end() || !((*it).second)) {
-        reply_pk.err_code = ERROR_SERVICE_NOT_FOUND;
-        std::stringstream ss;
-        ss << "not found service_name:[" << service_name << "]";
-        ELOG << reply_pk.msg_req << "|" << ss.str();
-        reply_pk.err_info = ss.str();
-
-        conn->getCodec()->encode(conn->getOutBuffer(), dynamic_cast<AbstractData *>(&reply_pk));
-
-        // LOG << "end dispatch client request, msgno=" << tmp->msg_req;
-        return;
-    }
-
-    service_ptr service = (*it).second;
-
-    const google::protobuf::MethodDescriptor *method = service->GetDescriptor()->FindMethodByName(
-        method_name);
-    if (!method) {
-        reply_pk.err_code = ERROR_METHOD_NOT_FOUND;
-        std::stringstream ss;
-        ss << "not found method_name:[" << method_name << "]";
-        ELOG << reply_pk.msg_req << "|" << ss.str();
-        reply_pk.err_info = ss.str();
-        conn->getCodec()->encode(conn->getOutBuffer(), dynamic_cast<AbstractData *>(&reply_pk));
-        return;
+    auto cached = m_method_map.find(tmp->service_full_name);
+    if (cached != m_method_map.end()) {
+        service = cached->second.service;
+        method = cached->second.method;
+        method_name = method->name();
+    } else {
+        if (!parseServiceFullName(tmp->service_full_name, service_name, method_name)) {
+            ELOG << reply_pk.msg_req << "|parse service name " << tmp->service_full_name << "error";
+
+            reply_pk.err_code = ERROR_PARSE_SERVICE_NAME;
+            std::stringstream ss;
+            ss << "cannot parse service_name:[" << tmp->service_full_name << "]";
+            reply_pk.err_info = ss.str();
+            conn->reply(dynamic_cast<AbstractData *>(&reply_pk));
+            return;
+        }
+
+        auto it = m_service_map.find(service_name);
+        if (it == m_service_map.end() || !((*it).second)) {
+            reply_pk.err_code = ERROR_SERVICE_NOT_FOUND;
+            std::stringstream ss;
+            ss << "not found service_name:[" << service_name << "]";
+            ELOG << reply_pk.msg_req << "|" << ss.str();
+            reply_pk.err_info = ss.str();
+
+            conn->reply(dynamic_cast<AbstractData *>(&reply_pk));
+
+            // LOG << "end dispatch client request, msgno=" << tmp->msg_req;
+            return;
+        }
+
+        service = (*it).second;
+        method = service->GetDescriptor()->FindMethodByName(method_name);
+        if (!method) {
+            reply_pk.err_code = ERROR_METHOD_NOT_FOUND;
+            std::stringstream ss;
+            ss << "not found method_name:[" << method_name << "]";
+            ELOG << reply_pk.msg_req << "|" << ss.str();
+            reply_pk.err_info = ss.str();
+            conn->reply(dynamic_cast<AbstractData *>(&reply_pk));
+            return;
+        }
     }
 
-    google::protobuf::Message *request = service->GetRequestPrototype(method).New();
+    // request and response of this call live in one arena, freed together
+    google::protobuf::Arena arena;
+    google::protobuf::Message *request = service->GetRequestPrototype(method).New(&arena);
     // DLOG << reply_pk.msg_req << "|request.name = " << request->GetDescriptor()->full_name();
 
     if (!request->ParseFromString(tmp->pb_data)) {
@@ -89,8 +100,7 @@ void ZRpcDispacther::dispatch(AbstractData *data, TcpConnection *conn) {
            << "]";
         reply_pk.err_info = ss.str();
         ELOG << reply_pk.msg_req << "|" << ss.str();
-        delete request;
-        conn->getCodec()->encode(conn->getOutBuffer(), dynamic_cast<AbstractData *>(&reply_pk));
+        conn->reply(dynamic_cast<AbstractData *>(&reply_pk));
         return;
     }
 
@@ -98,7 +108,7 @@ void ZRpcDispacther::dispatch(AbstractData *data, TcpConnection *conn) {
     // LOG << reply_pk.msg_req << "|Get client request data:" << request->ShortDebugString();
     // LOG << "============================================================";
 
-    google::protobuf::Message *response = service->GetResponsePrototype(method).New();
+    google::protobuf::Message *response = service->GetResponsePrototype(method).New(&arena);
 
     // DLOG << reply_pk.msg_req << "|response.name = " << response->GetDescriptor()->full_name();
 
@@ -114,8 +124,7 @@ void ZRpcDispacther::dispatch(AbstractData *data, TcpConnection *conn) {
 
     // DLOG << "Call [" << reply_pk.service_full_name << "] succ, now send reply package";
 
-    if (!(response->SerializeToString(&(reply_pk.pb_data)))) {
-        reply_pk.pb_data = "";
+    if (!response->IsInitialized()) {
         ELOG << reply_pk.msg_req << "|reply error! encode reply package error";
         reply_pk.err_code = ERROR_FAILED_SERIALIZE;
         reply_pk.err_info = "failed to serilize relpy data";
@@ -123,12 +132,12 @@ void ZRpcDispacther::dispatch(AbstractData *data, TcpConnection *conn) {
         // LOG << "============================================================";
         // LOG << reply_pk.msg_req << "|Set server response data:" << response->ShortDebugString();
         // LOG << "============================================================";
-    }
 
-    delete request;
-    delete response;
+        // serialized by the codec straight into the write buffer
+        reply_pk.pb_message = response;
+    }
 
-    conn->getCodec()->encode(conn->getOutBuffer(), dynamic_cast<AbstractData *>(&reply_pk));
+    conn->reply(dynamic_cast<AbstractData *>(&reply_pk));
 }
 
 bool ZRpcDispacther::parseServiceFullName(const std::string &full_name,
@@ -153,8 +162,14 @@ bool ZRpcDispacther::parseServiceFullName(const std::string &full_name,
 }
 
 void ZRpcDispacther::registerService(service_ptr service) {
-    std::string service_name = service->GetDescriptor()->full_name();
+    const google::protobuf::ServiceDescriptor *desc = service->GetDescriptor();
+    std::string service_name = desc->full_name();
     m_service_map[service_name] = service;
+
+    for (int i = 0; i < desc->method_count(); ++i) {
+        const google::protobuf::MethodDescriptor *method = desc->method(i);
+        m_method_map[service_name + "." + method->name()] = { service, method };
+    }
     // LOG << "succ register service[" << service_name << "]!";
 }
 
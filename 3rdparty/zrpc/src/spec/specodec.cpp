@@ -7,9 +7,11 @@
 #include <sstream>
 #include <memory>
 #include <string.h>
+#include <google/protobuf/message_lite.h>
 #include "specodec.h"
 #include "utils.h"
 #include "co/log.h"
+#include "co/defer.h"
 #include "abstractdata.h"
 #include "specdata.h"
 
@@ -25,39 +27,12 @@ ZRpcCodeC::ZRpcCodeC() {
 ZRpcCodeC::~ZRpcCodeC() {
 }
 
-void ZRpcCodeC::encode(TcpBuffer *buf, AbstractData *data) {
-    if (!buf || !data) {
-        ELOG << "encode error! buf or data nullptr";
-        return;
-    }
-    // DLOG << "test encode start";
-    SpecDataStruct *tmp = dynamic_cast<SpecDataStruct *>(data);
-
-    uint32_t len = 0;
-    const char *re = encodePbData(tmp, len);
-    if (re == nullptr || len == 0 || !tmp->encode_succ) {
-        ELOG << "encode error";
-        data->encode_succ = false;
-        return;
-    }
-    // DLOG << "encode package len = " << len;
-    if (buf != nullptr) {
-        buf->writeToBuffer(re, len);
-        // DLOG << "succ encode and write to buffer, writeindex=" << buf->writeIndex();
-    }
-    data = tmp;
-    if (re) {
-        free((void *)re);
-        re = NULL;
-    }
-    // DLOG << "test encode end";
-}
-
-const char *ZRpcCodeC::encodePbData(SpecDataStruct *data, uint32_t &len) {
+// check the data and work out the package length, pb_len is the length of business pb data
+static bool preparePackage(SpecDataStruct *data, uint32_t &pk_len, size_t &pb_len) {
     if (data->service_full_name.empty()) {
         ELOG << "parse error, service_full_name is empty";
         data->encode_succ = false;
-        return nullptr;
+        return false;
     }
     if (data->msg_req.empty()) {
         data->msg_req = Util::genMsgNumber();
@@ -65,12 +40,24 @@ const char *ZRpcCodeC::encodePbData(SpecDataStruct *data, uint32_t &len) {
         // DLOG << "generate msgno = " << data->msg_req;
     }
 
-    uint32_t pk_len = 2 * sizeof(char) + 6 * sizeof(uint32_t) + data->pb_data.length() +
-                     data->service_full_name.length() + data->msg_req.length() +
-                     data->err_info.length();
+    // ByteSizeLong also caches the size used by SerializeWithCachedSizesToArray
+    pb_len = data->pb_message ? data->pb_message->ByteSizeLong() : data->pb_data.length();
 
-    // DLOG << "encode pk_len = " << pk_len;
-    char *buf = reinterpret_cast<char *>(malloc(pk_len));
+    size_t len = 2 * sizeof(char) + 6 * sizeof(uint32_t) + pb_len +
+                 data->service_full_name.length() + data->msg_req.length() +
+                 data->err_info.length();
+    if (len > static_cast<size_t>(INT32_MAX)) {
+        ELOG << "encode error, package too large, len = " << len;
+        data->encode_succ = false;
+        return false;
+    }
+
+    pk_len = static_cast<uint32_t>(len);
+    return true;
+}
+
+// write the whole package to buf, which must have room for pk_len bytes
+static void writePackage(SpecDataStruct *data, char *buf, uint32_t pk_len, size_t pb_len) {
     char *tmp = buf;
     *tmp = PB_START;
     tmp++;
@@ -119,9 +106,13 @@ const char *ZRpcCodeC::encodePbData(SpecDataStruct *data, uint32_t &len) {
         tmp += err_info_len;
     }
 
-    memcpy(tmp, &(data->pb_data[0]), data->pb_data.length());
-    tmp += data->pb_data.length();
-    // DLOG << "pb_data_len= " << data->pb_data.length();
+    if (data->pb_message) {
+        data->pb_message->SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t *>(tmp));
+    } else if (pb_len != 0) {
+        memcpy(tmp, &(data->pb_data[0]), pb_len);
+    }
+    tmp += pb_len;
+    // DLOG << "pb_data_len= " << pb_len;
 
     int32_t checksum = 1;
     int32_t checksum_net = hton32(checksum);
@@ -138,7 +129,41 @@ const char *ZRpcCodeC::encodePbData(SpecDataStruct *data, uint32_t &len) {
     // checksum has not been implemented yet, directly skip chcksum
     data->check_num = checksum;
     data->encode_succ = true;
+}
 
+void ZRpcCodeC::encode(TcpBuffer *buf, AbstractData *data) {
+    if (!buf || !data) {
+        ELOG << "encode error! buf or data nullptr";
+        return;
+    }
+    // DLOG << "test encode start";
+    SpecDataStruct *tmp = dynamic_cast<SpecDataStruct *>(data);
+
+    uint32_t pk_len = 0;
+    size_t pb_len = 0;
+    if (!tmp || !preparePackage(tmp, pk_len, pb_len)) {
+        ELOG << "encode error";
+        data->encode_succ = false;
+        return;
+    }
+
+    // build the package in place, no temporary package copy
+    buf->ensureWriteAble(static_cast<int>(pk_len));
+    writePackage(tmp, &(buf->m_buffer[static_cast<size_t>(buf->writeIndex())]), pk_len, pb_len);
+    buf->recycleWrite(static_cast<int>(pk_len));
+    // DLOG << "succ encode and write to buffer, writeindex=" << buf->writeIndex();
+    // DLOG << "test encode end";
+}
+
+const char *ZRpcCodeC::encodePbData(SpecDataStruct *data, uint32_t &len) {
+    uint32_t pk_len = 0;
+    size_t pb_len = 0;
+    if (!preparePackage(data, pk_len, pb_len))
+        return nullptr;
+
+    // DLOG << "encode pk_len = " << pk_len;
+    char *buf = reinterpret_cast<char *>(malloc(pk_len));
+    writePackage(data, buf, pk_len, pb_len);
     len = pk_len;
 
     return buf;
@@ -151,7 +176,8 @@ void ZRpcCodeC::decode(TcpBuffer *buf, AbstractData *data) {
         return;
     }
 
-    std::vector<char> tmp = buf->getBufferVector();
+    // parse in place, the read index is moved once the package is done with
+    const std::vector<char> &tmp = buf->m_buffer;
     // int total_size = buf->readAble();
     int start_index = buf->readIndex();
     int end_index = -1;
@@ -189,7 +215,7 @@ void ZRpcCodeC::decode(TcpBuffer *buf, AbstractData *data) {
         return;
     }
 
-    buf->recycleRead(end_index + 1 - start_index);
+    defer(buf->recycleRead(end_index + 1 - start_index));
 
     // DLOG << "m_read_buffer size=" << buf->getBufferVector().size() << "rd=" << buf->readIndex()
     //      << "wd=" << buf->writeIndex();
@@ -287,8 +313,7 @@ void ZRpcCodeC::decode(TcpBuffer *buf, AbstractData *data) {
     }
     // DLOG << "pb_data_index = " << pb_data_index << ", pb_data.length = " << pb_data_len;
 
-    std::string pb_data_str(&tmp[pb_data_index], pb_data_len);
-    pb_struct->pb_data = pb_data_str;
+    pb_struct->pb_data.assign(&tmp[pb_data_index], pb_data_len);
 
     // DLOG << "decode succ,  pk_len = " << pk_len << ", service_name = " <<
     // pb_struct->service_full_name;
@@ -6,9 +6,14 @@
 #include "zrpc.h"
 #include "co/log.h"
 #include "net/tcpserver.h"
+#include "net/socktuner.h"
 
 namespace zrpc_ns {
 
+void setCongestionControl(const char *name) {
+    SockTuner::setCongestion(name ? name : "");
+}
+
 ZRpcClient::ZRpcClient(const char *ip, uint16 port, bool ssl, const bool isLong) {
     zrpc_ns::NetAddress::ptr addr = std::make_shared<zrpc_ns::NetAddress>(ip, port, ssl);
     m_channel = std::make_shared<ZRpcChannel>(addr, isLong);
@@ -81,4 +86,19 @@ bool ZRpcServer::checkConnected()
     return (static_cast<ZRpcServerImpl *>(_p))->checkConnected();
 }
 
+void ZRpcServer::setMaxInflight(int count)
+{
+    (static_cast<ZRpcServerImpl *>(_p))->getServer()->setMaxInflight(count);
+}
+
+void ZRpcServer::setMaxPeerConnections(int count)
+{
+    (static_cast<ZRpcServerImpl *>(_p))->getServer()->setMaxPeerConnections(count);
+}
+
+ConnectionStats ZRpcServer::stats()
+{
+    return (static_cast<ZRpcServerImpl *>(_p))->getServer()->stats();
+}
+
 } // namespace zrpc_ns
@@ -14,23 +14,112 @@
 #include <QSharedPointer>
 #include <QReadWriteLock>
 
+#include <memory>
+#include <typeinfo>
+
 DPF_BEGIN_NAMESPACE
 
+/*
+ * Direct call to a handler without QVariant boxing, only used when the
+ * published argument types are exactly the handler's parameter types
+ */
+struct TypedInvoker
+{
+    const std::type_info *signature { nullptr };
+    std::shared_ptr<void> func;
+
+    template<class... Args>
+    inline bool matches() const
+    {
+        return signature && *signature == typeid(void(std::decay_t<Args>...));
+    }
+
+    // returns the handler's result if it returns bool, otherwise false
+    template<class... Args>
+    inline bool invoke(const Args &... args) const
+    {
+        using Func = std::function<bool(const std::decay_t<Args> &...)>;
+        return (*static_cast<Func *>(func.get()))(args...);
+    }
+};
+
+template<class Arg>
+struct IsTypedArg
+{
+    // non-const references may be written by the handler, keep them on the boxed path
+    static constexpr bool value = std::is_same<Arg, std::decay_t<Arg>>::value
+            || std::is_same<Arg, const std::decay_t<Arg> &>::value;
+};
+
+template<class T, class C, class R, class... Args>
+inline TypedInvoker makeTypedInvoker(T *obj, R (C::*method)(Args...))
+{
+    if constexpr (!(IsTypedArg<Args>::value && ...)) {
+        return {};
+    } else {
+        using Func = std::function<bool(const std::decay_t<Args> &...)>;
+        auto func = std::make_shared<Func>([obj, method](const std::decay_t<Args> &... args) -> bool {
+            if constexpr (std::is_same<R, bool>::value) {
+                return (obj->*method)(args...);
+            } else {
+                (obj->*method)(args...);
+                return false;
+            }
+        });
+        return TypedInvoker { &typeid(void(std::decay_t<Args>...)), func };
+    }
+}
+
 class EventDispatcher
 {
 public:
     using Listener = std::function<QVariant(const QVariantList &)>;
-    using HandlerList = QList<EventHandler<Listener>>;
-    using FilterList = QList<EventHandler<Listener>>;
+
+    struct Handler : EventHandler<Listener>
+    {
+        TypedInvoker typed;
+
+        inline Handler(QObject *obj, void *func, Listener method, TypedInvoker invoker)
+            : EventHandler<Listener>(obj, func, method),
+              typed(std::move(invoker))
+        {
+        }
+    };
+
+    using HandlerList = QList<Handler>;
+    using FilterList = QList<Handler>;
+    using HandlerListPtr = std::shared_ptr<const HandlerList>;
 
     bool dispatch();
     bool dispatch(const QVariantList &params);
     template<class T, class... Args>
-    inline bool dispatch(T param, Args &&... args)
+    inline bool dispatch(T param, const Args &... args)
     {
-        QVariantList ret;
-        makeVariantList(&ret, param, std::forward<Args>(args)...);
-        return dispatch(ret);
+        // Dispatch works on a snapshot, handlers may be added or removed meanwhile
+        HandlerListPtr filters { std::atomic_load(&filterList) };
+        HandlerListPtr handlers { std::atomic_load(&handlerList) };
+
+        // boxed once, only if some handler has no typed path for these arguments
+        QVariantList boxed;
+        auto boxedArgs = [&]() -> const QVariantList & {
+            if (boxed.isEmpty())
+                makeVariantList(&boxed, param, args...);
+            return boxed;
+        };
+
+        for (const Handler &h : *filters) {
+            if (h.typed.matches<T, Args...>() ? h.typed.invoke(param, args...) : h.handler(boxedArgs()).toBool())
+                return false;
+        }
+
+        for (const Handler &h : *handlers) {
+            if (h.typed.matches<T, Args...>())
+                h.typed.invoke(param, args...);
+            else
+                h.handler(boxedArgs());
+        }
+
+        return true;
     }
 
     QFuture<bool> asyncDispatch();
@@ -43,6 +132,7 @@ public:
         return asyncDispatch(ret);
     }
 
+    // Writers are serialized by EventDispatcherManager's lock, readers never lock
     template<class T, class Func>
     inline void append(T *obj, Func method)
     {
@@ -54,7 +144,9 @@ public:
             return helper.invoke(args);
         };
 
-        handlerList.push_back(EventHandler<Listener> { obj, memberFunctionVoidCast(method), func });
+        HandlerList list { *std::atomic_load(&handlerList) };
+        list.push_back(Handler { obj, memberFunctionVoidCast(method), func, makeTypedInvoker(obj, method) });
+        std::atomic_store(&handlerList, HandlerListPtr(new HandlerList(std::move(list))));
     }
 
     template<class T, class Func>
@@ -64,14 +156,17 @@ public:
         static_assert(!std::is_pointer<T>::value, "Receiver::bind's template type T must not be a pointer type");
 
         bool ret { true };
-        for (auto handler : handlerList) {
+        const HandlerListPtr old { std::atomic_load(&handlerList) };
+        HandlerList list { *old };
+        for (auto handler : *old) {
             if (handler.compare(obj, method)) {
-                if (!handlerList.removeOne(handler)) {
+                if (!list.removeOne(handler)) {
                     qWarning() << "Cannot remove: " << handler.objectIndex->objectName();
                     ret = false;
                 }
             }
         }
+        std::atomic_store(&handlerList, HandlerListPtr(new HandlerList(std::move(list))));
 
         return ret;
     }
@@ -90,7 +185,10 @@ public:
             EventHelper<decltype(method)> helper = (EventHelper<decltype(method)>(obj, method));
             return helper.invoke(args).toBool();
         };
-        filterList.push_back(EventHandler<Listener> { obj, memberFunctionVoidCast(method), func });
+
+        FilterList list { *std::atomic_load(&filterList) };
+        list.push_back(Handler { obj, memberFunctionVoidCast(method), func, makeTypedInvoker(obj, method) });
+        std::atomic_store(&filterList, HandlerListPtr(new FilterList(std::move(list))));
     }
 
     template<class T, class Func>
@@ -104,21 +202,26 @@ public:
         static_assert(std::is_same<bool, ReturnType<decltype(method)>>::value, "Template method's ReturnType must is bool");
 #endif
         bool ret { true };
-        for (auto handler : filterList) {
+        const HandlerListPtr old { std::atomic_load(&filterList) };
+        FilterList list { *old };
+        for (auto handler : *old) {
             if (handler.compare(obj, method)) {
-                if (!filterList.removeOne(handler)) {
+                if (!list.removeOne(handler)) {
                     qWarning() << "Cannot remove: " << handler.objectIndex->objectName();
                     ret = false;
                 }
             }
         }
+        std::atomic_store(&filterList, HandlerListPtr(new FilterList(std::move(list))));
 
         return ret;
     }
 
 private:
-    HandlerList handlerList {};
-    FilterList filterList {};
+    static bool dispatch(const FilterList &filters, const HandlerList &handlers, const QVariantList &params);
+
+    HandlerListPtr handlerList { new HandlerList };
+    HandlerListPtr filterList { new FilterList };
 };
 
 class EventDispatcherManager
@@ -13,14 +13,21 @@ DCORE_USE_NAMESPACE
 
 static QVariantMap mergeCommonAttributes(const QVariantMap &args)
 {
-    QVariantMap map = args;
+    // 系统信息在进程内不会变化，只读取一次
+    static const QVariantMap sysAttributes = []() {
+        QVariantMap attrs;
+        if (DSysInfo::isDeepin()) {
+            attrs.insert("systemVersion", DSysInfo::uosEditionName());
+            attrs.insert("versionNumber", DSysInfo::minorVersion());
+        }
+        attrs.insert("machineID", QSysInfo::machineUniqueId());
+        return attrs;
+    }();
 
-    if (DSysInfo::isDeepin()) {
-        map.insert("systemVersion", DSysInfo::uosEditionName());
-        map.insert("versionNumber", DSysInfo::minorVersion());
-    }
+    QVariantMap map = args;
+    for (auto iter = sysAttributes.cbegin(); iter != sysAttributes.cend(); ++iter)
+        map.insert(iter.key(), iter.value());
     map.insert("sysTime", QDateTime::currentDateTime().toString("yyyy/MM/dd"));
-    map.insert("machineID", QSysInfo::machineUniqueId());
 
     return map;
 }
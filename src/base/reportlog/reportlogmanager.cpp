@@ -26,7 +26,11 @@ ReportLogManager::~ReportLogManager()
 {
     if (reportWorkThread) {
         qInfo() << "Log thread start to quit";
-        reportWorkThread->quit();
+        // write what is still queued before the thread stops
+        QMetaObject::invokeMethod(reportWorker, [this]() {
+            reportWorker->flush();
+            reportWorkThread->quit();
+        }, Qt::QueuedConnection);
         reportWorkThread->wait(2000);
         qInfo() << "Log thread quited.";
     }
@@ -37,6 +41,7 @@ void ReportLogManager::init()
     reportWorker = new ReportLogWorker();
     if (!reportWorker->init()) {
         reportWorker->deleteLater();
+        reportWorker = nullptr;
         return;
     }
 
@@ -46,17 +51,12 @@ void ReportLogManager::init()
     });
     reportWorker->moveToThread(reportWorkThread);
 
-    initConnection();
-
     reportWorkThread->start();
 }
 
 void ReportLogManager::commit(const QString &type, const QVariantMap &args)
 {
-    Q_EMIT requestCommitLog(type, args);
-}
-
-void ReportLogManager::initConnection()
-{
-    connect(this, &ReportLogManager::requestCommitLog, reportWorker, &ReportLogWorker::commitLog, Qt::QueuedConnection);
+    // Events are queued and written in batches by the worker thread
+    if (reportWorker && reportWorkThread)
+        reportWorker->enqueue(type, args);
 }
@@ -18,15 +18,10 @@ public:
 
     void commit(const QString &type, const QVariantMap &args);
 
-Q_SIGNALS:
-    void requestCommitLog(const QString &type, const QVariantMap &args);
-
 private:
     explicit ReportLogManager(QObject *parent = nullptr);
     ~ReportLogManager();
 
-    void initConnection();
-
     QThread *reportWorkThread { nullptr };
     ReportLogWorker *reportWorker { nullptr };
 };
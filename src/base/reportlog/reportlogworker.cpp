@@ -12,9 +12,20 @@
 
 using namespace deepin_cross;
 
+// Events waiting to be written, newer ones are dropped when it is full
+static constexpr int kMaxPendingEvents = 512;
+// Queued events are written together once this many arrived ...
+static constexpr int kFlushBatchSize = 32;
+// ... or this long after the first one, whichever comes first
+static constexpr int kFlushInterval = 500;
+
 ReportLogWorker::ReportLogWorker(QObject *parent)
-    : QObject(parent)
+    : QObject(parent),
+      flushTimer(new QTimer(this))
 {
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(kFlushInterval);
+    connect(flushTimer, &QTimer::timeout, this, &ReportLogWorker::flush);
 }
 
 ReportLogWorker::~ReportLogWorker()
@@ -62,19 +73,55 @@ bool ReportLogWorker::init()
 
 void ReportLogWorker::commitLog(const QString &type, const QVariantMap &args)
 {
-    ReportDataInterface *interface = logDataObj.value(type, nullptr);
-    if (!interface) {
-        qInfo() << "Error: Log data object is not registed.";
-        return;
+    if (enqueue(type, args))
+        flush();
+}
+
+bool ReportLogWorker::enqueue(const QString &type, const QVariantMap &args)
+{
+    int size = 0;
+    {
+        QMutexLocker lk(&queueMutex);
+        if (pendingEvents.size() >= kMaxPendingEvents) {
+            ++droppedCount;
+            return false;
+        }
+
+        pendingEvents.enqueue({ type, args });
+        size = pendingEvents.size();
     }
-    QJsonObject jsonObject = interface->prepareData(args);
 
-    const QStringList &keys = commonData.keys();
-    foreach (const QString &key, keys) {
-        jsonObject.insert(key, commonData.value(key));   //add common data for each log commit
+    // Only the first event of a batch and a full batch wake up the worker thread
+    if (size == 1)
+        QMetaObject::invokeMethod(flushTimer, QOverload<>::of(&QTimer::start), Qt::QueuedConnection);
+    else if (size == kFlushBatchSize)
+        QMetaObject::invokeMethod(this, &ReportLogWorker::flush, Qt::QueuedConnection);
+
+    return true;
+}
+
+void ReportLogWorker::flush()
+{
+    flushTimer->stop();
+
+    QQueue<Event> events;
+    {
+        QMutexLocker lk(&queueMutex);
+        events.swap(pendingEvents);
     }
 
-    commit(jsonObject.toVariantHash());
+    const quint64 dropped = droppedCount.exchange(0);
+    if (dropped > 0)
+        qWarning() << "Report log queue is full, dropped" << dropped << "events.";
+
+    if (!writeEventLogFunc)
+        return;
+
+    for (const Event &event : events) {
+        const QByteArray &data = serialize(event);
+        if (!data.isEmpty())
+            writeEventLogFunc(data.toStdString());
+    }
 }
 
 bool ReportLogWorker::registerLogData(const QString &type, ReportDataInterface *dataObj)
@@ -86,12 +133,17 @@ bool ReportLogWorker::registerLogData(const QString &type, ReportDataInterface *
     return true;
 }
 
-void ReportLogWorker::commit(const QVariant &args)
+QByteArray ReportLogWorker::serialize(const Event &event) const
 {
-    if (args.isNull() || !args.isValid())
-        return;
-    const QJsonObject &dataObj = QJsonObject::fromVariantHash(args.toHash());
-    QJsonDocument doc(dataObj);
-    const QByteArray &sendData = doc.toJson(QJsonDocument::Compact);
-    writeEventLogFunc(sendData.data());
+    ReportDataInterface *interface = logDataObj.value(event.type, nullptr);
+    if (!interface) {
+        qInfo() << "Error: Log data object is not registed.";
+        return {};
+    }
+
+    QJsonObject jsonObject = interface->prepareData(event.args);
+    for (auto iter = commonData.constBegin(); iter != commonData.constEnd(); ++iter)
+        jsonObject.insert(iter.key(), iter.value());   //add common data for each log commit
+
+    return QJsonDocument(jsonObject).toJson(QJsonDocument::Compact);
 }
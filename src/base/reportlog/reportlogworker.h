@@ -9,6 +9,11 @@
 
 #include <QLibrary>
 #include <QJsonObject>
+#include <QMutex>
+#include <QQueue>
+#include <QTimer>
+
+#include <atomic>
 
 namespace deepin_cross {
 
@@ -24,12 +29,23 @@ public:
 
     bool init();
 
+    // Thread safe, returns false if the event was dropped because the queue is full
+    bool enqueue(const QString &type, const QVariantMap &args);
+
 public Q_SLOTS:
     void commitLog(const QString &type, const QVariantMap &args);
+    // Writes all queued events, runs in the worker thread
+    void flush();
 
 private:
+    struct Event
+    {
+        QString type;
+        QVariantMap args;
+    };
+
     bool registerLogData(const QString &type, ReportDataInterface *dataObj);
-    void commit(const QVariant &args);
+    QByteArray serialize(const Event &event) const;
 
     QLibrary logLibrary;
     InitEventLog initEventLogFunc = nullptr;
@@ -37,6 +53,11 @@ private:
 
     QJsonObject commonData;
     QHash<QString, ReportDataInterface *> logDataObj;
+
+    QMutex queueMutex;
+    QQueue<Event> pendingEvents;
+    QTimer *flushTimer { nullptr };
+    std::atomic<quint64> droppedCount { 0 };
 };
 }
 
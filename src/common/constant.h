@@ -199,6 +199,7 @@ enum JobTransFileOp {
     FIlE_DIR_CREATE = 0x0010, // 文件创建
     FILE_COUNTING = 0x0020, // 数据统计中
     FILE_COUNTED = 0X0040, // 数据统计完成
+    FILE_HOLE = 0x0080, // 稀疏文件空洞，不带数据，data_size为空洞长度
 };
 
 enum CurrentStatus {
@@ -9,13 +9,27 @@
 #include <QStandardPaths>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QDateTime>
+#include <QSaveFile>
 #include <QDebug>
 #include <QFile>
 #include <QDir>
+#include <QMutex>
 #include <QTimer>
 #include <QThread>
 #include <QUrl>
 
+#ifdef Q_OS_WIN
+#    include <io.h>
+#else
+#    include <unistd.h>
+#endif
+
+// Private group holding the generation of the snapshot in the setting file
+static constexpr char kGenerationGroup[] { "__generation__" };
+// The journal is merged back into the setting file once it grows past this
+static constexpr qint64 kMaxJournalSize { 256 * 1024 };
+
 class SettingsPrivate
 {
 public:
@@ -31,6 +45,25 @@ public:
     QString settingFile;
     QFileSystemWatcher *settingFileWatcher = nullptr;
 
+    // Generation of the latest snapshot, bumped on every full write
+    quint64 generation = 0;
+    // Changes to these groups are appended to the journal file
+    QSet<QString> journalGroups;
+    // group -> keys changed since the last sync, journal groups only
+    QHash<QString, QSet<QString>> journalChanges;
+    // A change outside the journal groups, the whole file must be written
+    bool fullWritePending = false;
+    bool journalOpened = false;
+    qint64 journalSize = 0;
+    QThread *compactThread = nullptr;
+
+    // Guards the setting file writes, which also happen on the compact thread
+    QMutex writeMutex;
+    // Generation, size and time of our last write, to tell it apart from outside edits
+    quint64 writtenGeneration = 0;
+    qint64 writtenSize = -1;
+    QDateTime writtenTime;
+
     Settings *q_ptr;
 
     struct Data
@@ -71,7 +104,21 @@ public:
 
     void fromJsonFile(const QString &fileName, Data *data);
     void fromJson(const QByteArray &json, Data *data);
-    QByteArray toJson(const Data &data);
+    QByteArray toJson(const Data &data, quint64 generation);
+
+    QString journalFile() const { return settingFile + ".journal"; }
+    QString oldJournalFile() const { return settingFile + ".journal.old"; }
+
+    void loadSettingFile();
+    bool replayJournal(const QString &fileName, quint64 base);
+    void recordChange(const QString &group, const QString &key);
+    bool writeSnapshot(const QByteArray &json, quint64 generation);
+    bool writeAll();
+    bool appendJournal();
+    void compact();
+    void waitCompact();
+    bool isOwnWrite();
+    void watchFiles();
 
     void makeSettingFileToDirty(bool dirty)
     {
@@ -99,6 +146,7 @@ public:
     }
 
     void _q_onFileChanged(const QString &filePath);
+    void _q_onDirectoryChanged();
 };
 
 SettingsPrivate::SettingsPrivate(Settings *qq)
@@ -169,7 +217,7 @@ void SettingsPrivate::fromJson(const QByteArray &json, Data *data)
     }
 }
 
-QByteArray SettingsPrivate::toJson(const Data &data)
+QByteArray SettingsPrivate::toJson(const Data &data, quint64 generation)
 {
     QJsonObject root_object;
 
@@ -177,19 +225,324 @@ QByteArray SettingsPrivate::toJson(const Data &data)
         root_object.insert(begin.key(), QJsonValue(QJsonObject::fromVariantHash(begin.value())));
     }
 
+    root_object.insert(kGenerationGroup, QJsonObject { { "value", QString::number(generation) } });
+
     return QJsonDocument(root_object).toJson();
 }
 
+static bool syncToDisk(QFile &file)
+{
+    if (!file.flush())
+        return false;
+
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+void SettingsPrivate::loadSettingFile()
+{
+    fromJsonFile(settingFile, &writableData);
+
+    const quint64 base = writableData.privateValues.value(kGenerationGroup).value("value").toULongLong();
+    generation = qMax(generation, base);
+
+    // Journals older than the snapshot are already part of it
+    if (replayJournal(oldJournalFile(), base)) {
+        // An interrupted merge, write everything out again
+        fullWritePending = true;
+        makeSettingFileToDirty(true);
+    }
+
+    journalOpened = replayJournal(journalFile(), base);
+    journalSize = journalOpened ? QFileInfo(journalFile()).size() : 0;
+}
+
+bool SettingsPrivate::replayJournal(const QString &fileName, quint64 base)
+{
+    QFile file(fileName);
+
+    if (!file.exists()) {
+        return false;
+    }
+
+    if (!file.open(QFile::ReadOnly)) {
+        qWarning() << file.errorString();
+        return false;
+    }
+
+    const QJsonObject &header = QJsonDocument::fromJson(file.readLine()).object();
+
+    if (header.value("base").toString().toULongLong() < base) {
+        file.remove();
+        return false;
+    }
+
+    while (!file.atEnd()) {
+        const QJsonDocument &doc = QJsonDocument::fromJson(file.readLine());
+
+        // A torn tail from an interrupted append
+        if (!doc.isObject()) {
+            break;
+        }
+
+        const QJsonObject &entry = doc.object();
+        const QString &group = entry.value("group").toString();
+        const QString &key = entry.value("key").toString();
+
+        if (entry.value("removed").toBool()) {
+            writableData.values[group].remove(key);
+        } else {
+            writableData.setValue(group, key, entry.value("value").toVariant());
+        }
+    }
+
+    return true;
+}
+
+void SettingsPrivate::recordChange(const QString &group, const QString &key)
+{
+    if (journalGroups.contains(group)) {
+        journalChanges[group].insert(key);
+    } else {
+        fullWritePending = true;
+    }
+
+    makeSettingFileToDirty(true);
+}
+
+bool SettingsPrivate::writeSnapshot(const QByteArray &json, quint64 generation)
+{
+    QMutexLocker lk(&writeMutex);
+
+    // A newer snapshot is already on disk
+    if (generation <= writtenGeneration) {
+        return true;
+    }
+
+    QFileInfo info(settingFile);
+    info.absoluteDir().mkpath(".");
+
+    // Written to a temporary file that replaces the old one on commit
+    QSaveFile file(settingFile);
+
+    if (!file.open(QFile::WriteOnly)) {
+        qWarning() << file.errorString();
+        return false;
+    }
+
+    if (file.write(json) != json.size() || !file.commit()) {
+        qWarning() << file.errorString();
+        return false;
+    }
+
+    writtenGeneration = generation;
+    info.refresh();
+    writtenSize = info.size();
+    writtenTime = info.lastModified();
+
+    return true;
+}
+
+bool SettingsPrivate::writeAll()
+{
+    waitCompact();
+
+    const quint64 gen = ++generation;
+
+    if (!writeSnapshot(toJson(writableData, gen), gen)) {
+        return false;
+    }
+
+    QFile::remove(journalFile());
+    QFile::remove(oldJournalFile());
+    journalOpened = false;
+    journalSize = 0;
+
+    return true;
+}
+
+bool SettingsPrivate::appendJournal()
+{
+    QByteArray lines;
+
+    // Another process may have started a journal on the same snapshot
+    if (!journalOpened) {
+        QFile current(journalFile());
+        if (current.open(QFile::ReadOnly)
+            && QJsonDocument::fromJson(current.readLine()).object().value("base").toString().toULongLong() == generation) {
+            journalOpened = true;
+        }
+    }
+
+    if (!journalOpened) {
+        lines += QJsonDocument(QJsonObject { { "base", QString::number(generation) } }).toJson(QJsonDocument::Compact) + '\n';
+    }
+
+    for (auto begin = journalChanges.constBegin(); begin != journalChanges.constEnd(); ++begin) {
+        const QVariantHash &values = writableData.values.value(begin.key());
+
+        for (const QString &key : begin.value()) {
+            QJsonObject entry { { "group", begin.key() }, { "key", key } };
+
+            if (values.contains(key)) {
+                entry.insert("value", QJsonValue::fromVariant(values.value(key)));
+            } else {
+                entry.insert("removed", true);
+            }
+
+            lines += QJsonDocument(entry).toJson(QJsonDocument::Compact) + '\n';
+        }
+    }
+
+    QFileInfo(settingFile).absoluteDir().mkpath(".");
+
+    QFile file(journalFile());
+
+    if (!file.open(journalOpened ? QFile::Append : QFile::WriteOnly | QFile::Truncate)) {
+        qWarning() << file.errorString();
+        return false;
+    }
+
+    if (file.write(lines) != lines.size() || !syncToDisk(file)) {
+        qWarning() << file.errorString();
+        return false;
+    }
+
+    journalOpened = true;
+    // Other processes may append too, the size we know is the one on disk
+    journalSize = file.size();
+
+    if (journalSize > kMaxJournalSize) {
+        compact();
+    }
+
+    return true;
+}
+
+void SettingsPrivate::compact()
+{
+    waitCompact();
+
+    // Left over from a failed merge, merge both right here
+    if (QFile::exists(oldJournalFile()) || !QFile::rename(journalFile(), oldJournalFile())) {
+        writeAll();
+        return;
+    }
+
+    // Later changes go to a new journal on top of this snapshot
+    const quint64 gen = ++generation;
+    const QByteArray &json = toJson(writableData, gen);
+    journalOpened = false;
+    journalSize = 0;
+
+    const QString oldJournal = oldJournalFile();
+    compactThread = QThread::create([this, json, gen, oldJournal] {
+        if (writeSnapshot(json, gen)) {
+            QFile::remove(oldJournal);
+        }
+    });
+    compactThread->start();
+}
+
+void SettingsPrivate::waitCompact()
+{
+    if (!compactThread) {
+        return;
+    }
+
+    compactThread->wait();
+    delete compactThread;
+    compactThread = nullptr;
+}
+
+bool SettingsPrivate::isOwnWrite()
+{
+    const QFileInfo info(settingFile);
+
+    {
+        QMutexLocker lk(&writeMutex);
+
+        if (!info.exists()) {
+            return false;
+        }
+
+        // The usual case, nothing to parse
+        if (info.size() == writtenSize && info.lastModified() == writtenTime) {
+            return true;
+        }
+    }
+
+    // Only the time differs when the file was touched, the generation tells
+    QFile file(settingFile);
+
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    const QByteArray &json = file.readAll();
+    const quint64 gen = QJsonDocument::fromJson(json).object().value(kGenerationGroup).toObject().value("value").toString().toULongLong();
+
+    // Another process can reach the same generation, the size tells most of those apart
+    QMutexLocker lk(&writeMutex);
+    return gen != 0 && gen == writtenGeneration && json.size() == writtenSize;
+}
+
+void SettingsPrivate::watchFiles()
+{
+    if (!settingFileWatcher)
+        return;
+
+    // Both files are replaced or created again, watch the current ones
+    const QStringList &watched = settingFileWatcher->files();
+    for (const QString &file : { settingFile, journalFile() }) {
+        if (!watched.contains(file) && QFile::exists(file))
+            settingFileWatcher->addPath(file);
+    }
+}
+
+void SettingsPrivate::_q_onDirectoryChanged()
+{
+    const bool journalWatched = settingFileWatcher && settingFileWatcher->files().contains(journalFile());
+
+    watchFiles();
+
+    // A journal created by another process, its first lines came with it
+    if (!journalWatched && QFile::exists(journalFile()))
+        _q_onFileChanged(journalFile());
+}
+
 void SettingsPrivate::_q_onFileChanged(const QString &filePath)
 {
-    if (filePath != settingFile)
+    if (filePath == journalFile()) {
+        watchFiles();
+
+        // Removed on a full write, that write reloads through the setting file
+        const QFileInfo info(filePath);
+        if (!info.exists())
+            return;
+
+        // Our own appends leave it at the size we know
+        if (journalOpened && info.size() == journalSize)
+            return;
+    } else if (filePath == settingFile) {
+        watchFiles();
+
+        if (isOwnWrite())
+            return;
+    } else {
         return;
+    }
 
     const auto old_values = writableData.values;
 
     writableData.values.clear();
-    fromJsonFile(settingFile, &writableData);
-    makeSettingFileToDirty(false);
+    journalChanges.clear();
+    fullWritePending = false;
+    loadSettingFile();
+    makeSettingFileToDirty(fullWritePending);
 
     for (auto begin = writableData.values.constBegin(); begin != writableData.values.constEnd(); ++begin) {
         for (auto i = begin.value().constBegin(); i != begin.value().constEnd(); ++i) {
@@ -244,7 +597,7 @@ Settings::Settings(const QString &defaultFile, const QString &fallbackFile, cons
 
     d_ptr->fromJsonFile(defaultFile, &d_ptr->defaultData);
     d_ptr->fromJsonFile(fallbackFile, &d_ptr->fallbackData);
-    d_ptr->fromJsonFile(settingFile, &d_ptr->writableData);
+    d_ptr->loadSettingFile();
 }
 
 static QString getConfigFilePath(QStandardPaths::StandardLocation type, const QString &fileName, bool writable)
@@ -291,6 +644,8 @@ Settings::~Settings()
     if (d->settingFileIsDirty) {
         sync();
     }
+
+    d->waitCompact();
 }
 
 bool Settings::contains(const QString &group, const QString &key) const
@@ -451,7 +806,7 @@ bool Settings::setValueNoNotify(const QString &group, const QString &key, const
     }
 
     d->writableData.setValue(group, key, value);
-    d->makeSettingFileToDirty(true);
+    d->recordChange(group, key);
 
     return changed;
 }
@@ -466,7 +821,9 @@ void Settings::removeGroup(const QString &group)
 
     const QVariantHash &group_values = d->writableData.values.take(group);
 
-    d->makeSettingFileToDirty(true);
+    for (auto begin = group_values.constBegin(); begin != group_values.constEnd(); ++begin) {
+        d->recordChange(group, begin.key());
+    }
 
     for (auto begin = group_values.constBegin(); begin != group_values.constEnd(); ++begin) {
         const QVariant &new_value = value(group, begin.key());
@@ -493,7 +850,7 @@ void Settings::remove(const QString &group, const QString &key)
     }
 
     const QVariant &old_value = d->writableData.values[group].take(key);
-    d->makeSettingFileToDirty(true);
+    d->recordChange(group, key);
 
     const QVariant &new_value = value(group, key);
 
@@ -515,6 +872,7 @@ void Settings::clear()
     const QHash<QString, QVariantHash> old_values = d->writableData.values;
 
     d->writableData.values.clear();
+    d->fullWritePending = true;
     d->makeSettingFileToDirty(true);
 
     for (auto begin = old_values.constBegin(); begin != old_values.constEnd(); ++begin) {
@@ -546,7 +904,9 @@ void Settings::reload()
 
     d->writableData.privateValues.clear();
     d->writableData.values.clear();
-    d->fromJsonFile(d->settingFile, &d_ptr->writableData);
+    d->journalChanges.clear();
+    d->fullWritePending = false;
+    d->loadSettingFile();
 }
 
 bool Settings::sync()
@@ -557,20 +917,14 @@ bool Settings::sync()
         return true;
     }
 
-    const QByteArray &json = d->toJson(d->writableData);
-
-    QFile file(d->settingFile);
-
-    if (!file.open(QFile::WriteOnly)) {
-        return false;
-    }
-
-    bool ok = file.write(json) == json.size();
+    // Only journal groups changed, append the changed keys
+    const bool ok = d->fullWritePending ? d->writeAll() : d->appendJournal();
 
     if (ok) {
+        d->journalChanges.clear();
+        d->fullWritePending = false;
         d->makeSettingFileToDirty(false);
     }
-    file.close();
 
     return ok;
 }
@@ -621,6 +975,16 @@ void Settings::setAutoSync(bool autoSync)
     }
 }
 
+void Settings::setJournalGroups(const QStringList &groups)
+{
+    Q_D(Settings);
+
+    d->journalGroups.clear();
+    for (const QString &group : groups) {
+        d->journalGroups.insert(group);
+    }
+}
+
 void Settings::onFileChanged(const QString &filePath)
 {
     Q_D(Settings);
@@ -628,6 +992,14 @@ void Settings::onFileChanged(const QString &filePath)
     d->_q_onFileChanged(filePath);
 }
 
+void Settings::onDirectoryChanged(const QString &path)
+{
+    Q_UNUSED(path)
+    Q_D(Settings);
+
+    d->_q_onDirectoryChanged();
+}
+
 void Settings::setWatchChanges(bool watchChanges)
 {
     Q_D(Settings);
@@ -648,10 +1020,13 @@ void Settings::setWatchChanges(bool watchChanges)
             }
         }
 
-        d->settingFileWatcher = new QFileSystemWatcher({ d->settingFile }, this);
+        // The directory tells when the journal is created
+        d->settingFileWatcher = new QFileSystemWatcher({ d->settingFile, QFileInfo(d->settingFile).absolutePath() }, this);
         d->settingFileWatcher->moveToThread(thread());
+        d->watchFiles();
 
         connect(d->settingFileWatcher, &QFileSystemWatcher::fileChanged, this, &Settings::onFileChanged);
+        connect(d->settingFileWatcher, &QFileSystemWatcher::directoryChanged, this, &Settings::onDirectoryChanged);
     } else {
         if (d->settingFileWatcher) {
             d->settingFileWatcher->deleteLater();
@@ -46,6 +46,12 @@ public:
 
     bool sync();
 
+    // Changes to these groups are appended to a journal on sync instead of
+    // rewriting the whole file, the journal is merged back in the background.
+    // With watchChanges the journal is watched too, so appends of other
+    // processes are picked up.
+    void setJournalGroups(const QStringList &groups);
+
     bool autoSync() const;
     bool watchChanges() const;
 
@@ -53,6 +59,7 @@ public Q_SLOTS:
     void setAutoSync(bool autoSync);
     void setWatchChanges(bool watchChanges);
     void onFileChanged(const QString &filePath);
+    void onDirectoryChanged(const QString &path);
 
 Q_SIGNALS:
     void valueChanged(const QString &group, const QString &key, const QVariant &value);
@@ -17,13 +17,20 @@ bool EventDispatcher::dispatch()
 
 bool EventDispatcher::dispatch(const QVariantList &params)
 {
-    if (std::any_of(filterList.begin(), filterList.end(), [params](const EventHandler<Listener> &h) {
+    HandlerListPtr filters { std::atomic_load(&filterList) };
+    HandlerListPtr handlers { std::atomic_load(&handlerList) };
+    return dispatch(*filters, *handlers, params);
+}
+
+bool EventDispatcher::dispatch(const FilterList &filters, const HandlerList &handlers, const QVariantList &params)
+{
+    if (std::any_of(filters.begin(), filters.end(), [&params](const Handler &h) {
             return h.handler(params).toBool();
         })) {
         return false;
     }
 
-    std::for_each(handlerList.begin(), handlerList.end(), [params](const EventHandler<Listener> &h) {
+    std::for_each(handlers.begin(), handlers.end(), [&params](const Handler &h) {
         h.handler(params);
     });
 
@@ -37,8 +44,20 @@ QFuture<bool> EventDispatcher::asyncDispatch()
 
 QFuture<bool> EventDispatcher::asyncDispatch(const QVariantList &params)
 {
-    return QFuture<bool>(QtConcurrent::run([this, params]() -> bool {
-        return this->dispatch(params);
+    // The task owns its snapshot, so it does not depend on this dispatcher staying alive
+    HandlerListPtr filters { std::atomic_load(&filterList) };
+    HandlerListPtr handlers { std::atomic_load(&handlerList) };
+    if (filters->isEmpty() && handlers->isEmpty()) {
+        // nothing to run, no need for a worker task
+        QFutureInterface<bool> ready;
+        ready.reportStarted();
+        bool result { true };
+        ready.reportFinished(&result);
+        return ready.future();
+    }
+
+    return QFuture<bool>(QtConcurrent::run([filters, handlers, params]() -> bool {
+        return dispatch(*filters, *handlers, params);
     }));
 }
 
@@ -63,11 +82,9 @@ bool EventDispatcherManager::globalFiltered(EventType type, const QVariantList &
 {
     QReadLocker lk(&rwLock);
 
-    int size { globalFilterMap.size() };
-    for (int i = 0; i != size; ++i) {
-        auto key { globalFilterMap.keys()[i] };
-        if (key) {
-            auto func { globalFilterMap.value(key) };
+    for (auto iter = globalFilterMap.cbegin(); iter != globalFilterMap.cend(); ++iter) {
+        if (iter.key()) {
+            auto func { iter.value() };
             lk.unlock();
             return func(type, params);
         }
@@ -9,8 +9,20 @@
 #include <dde-cooperation-framework/lifecycle/plugin.h>
 #include <dde-cooperation-framework/lifecycle/plugincreator.h>
 
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#ifdef Q_OS_LINUX
+#    include <sys/stat.h>
+#endif
+
 DPF_BEGIN_NAMESPACE
 
+// bump when the cached layout changes
+static constexpr int kMetaCacheVersion = 1;
+
 PluginManagerPrivate::PluginManagerPrivate(PluginManager *qq)
     : q(qq)
 {
@@ -84,7 +96,15 @@ bool PluginManagerPrivate::stopPlugin(PluginMetaObjectPointer &pluginMetaObj)
  */
 bool PluginManagerPrivate::readPlugins()
 {
-    scanfAllPlugin(&readQueue, pluginLoadPaths, pluginLoadIIDs, blackPlguinNames);
+    QElapsedTimer timer;
+    timer.start();
+
+    QJsonObject metaCache = loadMetaCache();
+    const QJsonObject oldCache = metaCache;
+    scanfAllPlugin(&readQueue, pluginLoadPaths, pluginLoadIIDs, blackPlguinNames, &metaCache);
+    if (metaCache != oldCache)
+        saveMetaCache(metaCache);
+
     qInfo() << "Lazy load plugin names: " << lazyLoadPluginsNames;
     std::for_each(readQueue.begin(), readQueue.end(), [this](PluginMetaObjectPointer obj) {
         readJsonToMeta(obj);
@@ -102,6 +122,8 @@ bool PluginManagerPrivate::readPlugins()
     qDebug() << "End traversal of meta information for all plugins!";
 #endif
 
+    qInfo() << "Read" << readQueue.size() << "plugins in" << timer.elapsed() << "ms";
+
     return readQueue.isEmpty() ? false : true;
 }
 
@@ -114,13 +136,15 @@ bool PluginManagerPrivate::readPlugins()
 void PluginManagerPrivate::scanfAllPlugin(QQueue<PluginMetaObjectPointer> *destQueue,
                                           const QStringList &pluginPaths,
                                           const QStringList &pluginIIDs,
-                                          const QStringList &blackList)
+                                          const QStringList &blackList,
+                                          QJsonObject *metaCache)
 {
     Q_ASSERT(destQueue);
 
     if (pluginIIDs.isEmpty())
         return;
 
+    QStringList fileNames;
     for (const QString &path : pluginPaths) {
         QString libSuffix =
         #ifdef WIN32
@@ -135,24 +159,122 @@ void PluginManagerPrivate::scanfAllPlugin(QQueue<PluginMetaObjectPointer> *destQ
 
         while (dirItera.hasNext()) {
             dirItera.next();
+            fileNames.append(dirItera.path() + "/" + dirItera.fileName());
+        }
+    }
+
+    // 元数据未变化的插件直接使用缓存，其余的并行读取
+    QHash<QString, QJsonObject> metaJsons;
+    QStringList missed;
+    QJsonObject newCache;
+    for (const QString &fileName : fileNames) {
+        const QJsonObject &stamp = fileStamp(fileName);
+        const QJsonObject &cached = metaCache ? metaCache->value(fileName).toObject() : QJsonObject();
+        if (!cached.isEmpty() && cached.value("stamp").toObject() == stamp) {
+            metaJsons.insert(fileName, cached.value("meta").toObject());
+            newCache.insert(fileName, cached);
+        } else {
+            missed.append(fileName);
+        }
+    }
+
+    if (!missed.isEmpty()) {
+        qInfo() << "Reading metadata of" << missed.size() << "changed plugins";
+        const QList<QJsonObject> &results = QtConcurrent::blockingMapped<QList<QJsonObject>>(missed, [](const QString &fileName) {
+            return QPluginLoader(fileName).metaData();
+        });
+        for (int i = 0; i < missed.size(); ++i) {
+            metaJsons.insert(missed[i], results[i]);
+            newCache.insert(missed[i], QJsonObject { { "stamp", fileStamp(missed[i]) }, { "meta", results[i] } });
+        }
+    }
+
+    // drop the entries of removed plugins
+    if (metaCache)
+        *metaCache = newCache;
+
+    for (const QString &fileName : fileNames) {
+        const QJsonObject &metaJson = metaJsons.value(fileName);
+        QJsonObject &&dataJson = metaJson.value("MetaData").toObject();
+        QString &&iid = metaJson.value("IID").toString();
+        if (!pluginIIDs.contains(iid))
+            continue;
+
+        bool isVirtual = dataJson.contains(kVirtualPluginMeta) && dataJson.contains(kVirtualPluginList);
+        if (isVirtual) {
+            scanfVirtualPlugin(destQueue, fileName, metaJson, blackList);
+        } else {
             PluginMetaObjectPointer metaObj(new PluginMetaObject);
-            const QString &fileName { dirItera.path() + "/" + dirItera.fileName() };
             metaObj->d->loader->setFileName(fileName);
-            QJsonObject &&metaJson = metaObj->d->loader->metaData();
-            QJsonObject &&dataJson = metaJson.value("MetaData").toObject();
-            QString &&iid = metaJson.value("IID").toString();
-            if (!pluginIIDs.contains(iid))
-                continue;
-
-            bool isVirtual = dataJson.contains(kVirtualPluginMeta) && dataJson.contains(kVirtualPluginList);
-            if (isVirtual)
-                scanfVirtualPlugin(destQueue, fileName, dataJson, blackList);
-            else
-                scanfRealPlugin(destQueue, metaObj, dataJson, blackList);
+            metaObj->d->metaData = metaJson;
+            scanfRealPlugin(destQueue, metaObj, dataJson, blackList);
         }
     }
 }
 
+QString PluginManagerPrivate::metaCacheFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/plugin-metadata.json";
+}
+
+/*!
+ * \brief 读取插件元数据缓存, key 为插件文件路径
+ */
+QJsonObject PluginManagerPrivate::loadMetaCache()
+{
+    QFile file(metaCacheFile());
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    const QJsonObject &root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value("version").toInt() != kMetaCacheVersion)
+        return {};
+
+    return root.value("plugins").toObject();
+}
+
+void PluginManagerPrivate::saveMetaCache(const QJsonObject &cache)
+{
+    const QString &fileName = metaCacheFile();
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write plugin metadata cache:" << file.errorString();
+        return;
+    }
+
+    QJsonObject root { { "version", kMetaCacheVersion }, { "plugins", cache } };
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit())
+        qWarning() << "Failed to write plugin metadata cache:" << file.errorString();
+}
+
+/*!
+ * \brief 插件文件的修改时间、大小和 inode，任一变化都重新读取元数据
+ */
+QJsonObject PluginManagerPrivate::fileStamp(const QString &fileName)
+{
+    QJsonObject stamp;
+#ifdef Q_OS_LINUX
+    struct stat st;
+    if (::stat(QFile::encodeName(fileName).constData(), &st) != 0)
+        return stamp;
+
+    stamp.insert("mtime", QString::number(static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec));
+    stamp.insert("size", QString::number(static_cast<qint64>(st.st_size)));
+    stamp.insert("inode", QString::number(static_cast<quint64>(st.st_ino)));
+#else
+    QFileInfo info(fileName);
+    if (!info.exists())
+        return stamp;
+
+    stamp.insert("mtime", QString::number(info.lastModified().toMSecsSinceEpoch()));
+    stamp.insert("size", QString::number(info.size()));
+#endif
+    return stamp;
+}
+
 void PluginManagerPrivate::scanfRealPlugin(QQueue<PluginMetaObjectPointer> *destQueue, PluginMetaObjectPointer metaObj,
                                            const QJsonObject &dataJson, const QStringList &blackList)
 {
@@ -172,10 +294,11 @@ void PluginManagerPrivate::scanfRealPlugin(QQueue<PluginMetaObjectPointer> *dest
 }
 
 void PluginManagerPrivate::scanfVirtualPlugin(QQueue<PluginMetaObjectPointer> *destQueue, const QString &fileName,
-                                              const QJsonObject &dataJson, const QStringList &blackList)
+                                              const QJsonObject &metaJson, const QStringList &blackList)
 {
     Q_ASSERT(destQueue);
 
+    QJsonObject &&dataJson { metaJson.value("MetaData").toObject() };
     QJsonObject &&metaDataJson { dataJson.value(kVirtualPluginMeta).toObject() };
     QString &&realName { metaDataJson.value(kPluginName).toString() };
     if (blackList.contains(realName)) {
@@ -194,6 +317,7 @@ void PluginManagerPrivate::scanfVirtualPlugin(QQueue<PluginMetaObjectPointer> *d
 
         PluginMetaObjectPointer metaObj(new PluginMetaObject);
         metaObj->d->loader->setFileName(fileName);
+        metaObj->d->metaData = metaJson;
         metaObj->d->isVirtual = true;
         metaObj->d->realName = realName;
         metaObj->d->name = name;
@@ -210,7 +334,7 @@ void PluginManagerPrivate::readJsonToMeta(PluginMetaObjectPointer metaObject)
 {
     metaObject->d->state = PluginMetaObject::kReading;
 
-    QJsonObject &&jsonObj = metaObject->d->loader->metaData();
+    const QJsonObject &jsonObj = metaObject->d->metaData;
     if (jsonObj.isEmpty())
         return;
 
@@ -267,8 +391,11 @@ bool PluginManagerPrivate::loadPlugins()
 
     bool ret = true;
     std::for_each(loadQueue.begin(), loadQueue.end(), [&ret, this](PluginMetaObjectPointer pointer) {
+        QElapsedTimer timer;
+        timer.start();
         if (!PluginManagerPrivate::doLoadPlugin(pointer))
             ret = false;
+        pointer->d->loadCost = timer.elapsed();
     });
     qInfo() << "End loading all plugins.";
 
@@ -283,8 +410,11 @@ bool PluginManagerPrivate::initPlugins()
     qInfo() << "Start initializing all plugins: ";
     bool ret = true;
     std::for_each(loadQueue.begin(), loadQueue.end(), [&ret, this](PluginMetaObjectPointer pointer) {
+        QElapsedTimer timer;
+        timer.start();
         if (!PluginManagerPrivate::doInitPlugin(pointer))
             ret = false;
+        pointer->d->initCost = timer.elapsed();
     });
     qInfo() << "End initialization of all plugins.";
 
@@ -302,10 +432,14 @@ bool PluginManagerPrivate::startPlugins()
     qInfo() << "Start start all plugins: ";
     bool ret = true;
     std::for_each(loadQueue.begin(), loadQueue.end(), [&ret, this](PluginMetaObjectPointer pointer) {
+        QElapsedTimer timer;
+        timer.start();
         if (!PluginManagerPrivate::doStartPlugin(pointer))
             ret = false;
+        pointer->d->startCost = timer.elapsed();
     });
     qInfo() << "End start of all plugins.";
+    printStartupProfile();
 
     emit Listener::instance()->pluginsStarted();
     allPluginsStarted = true;
@@ -313,6 +447,21 @@ bool PluginManagerPrivate::startPlugins()
     return ret;
 }
 
+/*!
+ * \brief 输出每个插件各阶段的耗时(ms)
+ */
+void PluginManagerPrivate::printStartupProfile()
+{
+    qint64 total = 0;
+    qInfo() << "Plugin startup profile (load / init / start, ms):";
+    for (const auto &pointer : loadQueue) {
+        const auto &d = pointer->d;
+        qInfo().noquote() << QString("  %1: %2 / %3 / %4").arg(d->name).arg(d->loadCost).arg(d->initCost).arg(d->startCost);
+        total += qMax(d->loadCost, 0LL) + qMax(d->initCost, 0LL) + qMax(d->startCost, 0LL);
+    }
+    qInfo() << "Plugin startup total:" << total << "ms";
+}
+
 /*!
  * \brief 停止插件,仅主线程
  */
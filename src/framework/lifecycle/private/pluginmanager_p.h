@@ -60,13 +60,18 @@ public:
     static void scanfAllPlugin(QQueue<PluginMetaObjectPointer> *destQueue,
                                const QStringList &pluginPaths,
                                const QStringList &pluginIIDs,
-                               const QStringList &blackList);
+                               const QStringList &blackList,
+                               QJsonObject *metaCache = nullptr);
     static void scanfRealPlugin(QQueue<PluginMetaObjectPointer> *destQueue, PluginMetaObjectPointer metaObj,
                                 const QJsonObject &dataJson, const QStringList &blackList);
     static void scanfVirtualPlugin(QQueue<PluginMetaObjectPointer> *destQueue, const QString &fileName,
-                                   const QJsonObject &dataJson, const QStringList &blackList);
+                                   const QJsonObject &metaJson, const QStringList &blackList);
     static void readJsonToMeta(PluginMetaObjectPointer metaObject);
     static void jsonToMeta(PluginMetaObjectPointer metaObject, const QJsonObject &metaData);
+    static QString metaCacheFile();
+    static QJsonObject loadMetaCache();
+    static void saveMetaCache(const QJsonObject &cache);
+    static QJsonObject fileStamp(const QString &fileName);
     static void dependsSort(QQueue<PluginMetaObjectPointer> *dstQueue,
                             const QQueue<PluginMetaObjectPointer> *srcQueue);
 
@@ -75,6 +80,7 @@ private:
     bool doInitPlugin(PluginMetaObjectPointer pointer);
     bool doStartPlugin(PluginMetaObjectPointer pointer);
     bool doStopPlugin(PluginMetaObjectPointer pointer);
+    void printStartupProfile();
 
     static bool doPluginSort(const PluginDependGroup group,
                              QMap<QString, PluginMetaObjectPointer> src,
@@ -12,6 +12,7 @@
 #include <QString>
 #include <QStringList>
 #include <QSharedPointer>
+#include <QJsonObject>
 
 DPF_BEGIN_NAMESPACE
 
@@ -55,6 +56,12 @@ public:
     QList<PluginDepend> depends;
     QSharedPointer<Plugin> plugin;
     QSharedPointer<QPluginLoader> loader;
+    QJsonObject metaData;   // read once while scanning, may come from the cache
+
+    // startup profile, milliseconds spent in each phase, -1 if not run
+    qint64 loadCost { -1 };
+    qint64 initCost { -1 };
+    qint64 startCost { -1 };
 
     explicit PluginMetaObjectPrivate(PluginMetaObject *q)
         : q(q), loader(new QPluginLoader(nullptr))
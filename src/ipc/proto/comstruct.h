@@ -95,6 +95,7 @@ struct NodeInfo {
 struct NodeList {
     int32 code;
     co::vector<NodeInfo> peers;
+    int32 version;
 
     void from_json(const co::Json& _x_) {
         code = (int32)_x_.get("code").as_int64();
@@ -106,6 +107,7 @@ struct NodeList {
                 peers.emplace_back(std::move(_unamed_v2));
             }
         } while (0);
+        version = (int32)_x_.get("version").as_int64();
     }
 
     co::Json as_json() const {
@@ -118,6 +120,7 @@ struct NodeList {
             }
             _x_.add_member("peers", _unamed_v1);
         } while (0);
+        _x_.add_member("version", version);
         return _x_;
     }
 };
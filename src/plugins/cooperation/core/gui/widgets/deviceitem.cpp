@@ -41,12 +41,17 @@ void StateLabel::paintEvent(QPaintEvent *event)
     Q_UNUSED(event);
 
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.setPen(Qt::NoPen);
+    paintState(&painter, rect(), st, text());
+}
+
+void StateLabel::paintState(QPainter *painter, const QRect &rect, DeviceInfo::ConnectStatus state, const QString &text)
+{
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(Qt::NoPen);
 
     QColor brushColor;
     QColor textColor;
-    switch (st) {
+    switch (state) {
     case DeviceInfo::Connected:
         brushColor.setRgb(241, 255, 243);
         textColor.setRgb(51, 202, 78);
@@ -74,11 +79,11 @@ void StateLabel::paintEvent(QPaintEvent *event)
         break;
     }
 
-    painter.setBrush(brushColor);
-    painter.drawRoundedRect(rect(), 8, 8);
+    painter->setBrush(brushColor);
+    painter->drawRoundedRect(rect, 8, 8);
 
-    painter.setPen(textColor);
-    painter.drawText(rect(), Qt::AlignCenter, text());
+    painter->setPen(textColor);
+    painter->drawText(rect, Qt::AlignCenter, text);
 }
 
 DeviceItem::DeviceItem(QWidget *parent)
@@ -168,23 +173,33 @@ void DeviceItem::setDeviceName(const QString &name)
 void DeviceItem::setDeviceStatus(DeviceInfo::ConnectStatus status)
 {
     stateLabel->setState(status);
+    iconLabel->setPixmap(statusIcon(status).pixmap(52, 52));
+    stateLabel->setText(statusText(status));
+}
+
+QIcon DeviceItem::statusIcon(DeviceInfo::ConnectStatus status)
+{
+    switch (status) {
+    case DeviceInfo::Connected:
+        return QIcon::fromTheme(Kcomputer_connected);
+    case DeviceInfo::Connectable:
+        return QIcon::fromTheme(Kcomputer_can_connect);
+    case DeviceInfo::Offline:
+    default:
+        return QIcon::fromTheme(Kcomputer_off_line);
+    }
+}
+
+QString DeviceItem::statusText(DeviceInfo::ConnectStatus status)
+{
     switch (status) {
-    case DeviceInfo::Connected: {
-        QIcon icon = QIcon::fromTheme(Kcomputer_connected);
-        iconLabel->setPixmap(icon.pixmap(52, 52));
-        stateLabel->setText(tr("connected"));
-    } break;
-    case DeviceInfo::Connectable: {
-        QIcon icon = QIcon::fromTheme(Kcomputer_can_connect);
-        iconLabel->setPixmap(icon.pixmap(52, 52));
-        stateLabel->setText(tr("connectable"));
-    } break;
+    case DeviceInfo::Connected:
+        return tr("connected");
+    case DeviceInfo::Connectable:
+        return tr("connectable");
     case DeviceInfo::Offline:
-    default: {
-        QIcon icon = QIcon::fromTheme(Kcomputer_off_line);
-        iconLabel->setPixmap(icon.pixmap(52, 52));
-        stateLabel->setText(tr("offline"));
-    } break;
+    default:
+        return tr("offline");
     }
 }
 
@@ -24,6 +24,9 @@ public:
     void setState(DeviceInfo::ConnectStatus state) { st = state; }
     DeviceInfo::ConnectStatus state() const { return st; }
 
+    // Draws the state badge with the painter's current font
+    static void paintState(QPainter *painter, const QRect &rect, DeviceInfo::ConnectStatus state, const QString &text);
+
 protected:
     void paintEvent(QPaintEvent *event) override;
 
@@ -58,6 +61,9 @@ public:
     void setOperations(const QList<Operation> &operations);
     void updateOperations();
 
+    static QIcon statusIcon(DeviceInfo::ConnectStatus status);
+    static QString statusText(DeviceInfo::ConnectStatus status);
+
 public Q_SLOTS:
     void onButtonClicked(int index);
 
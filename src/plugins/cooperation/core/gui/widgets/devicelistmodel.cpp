@@ -0,0 +1,206 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "devicelistmodel.h"
+#include "deviceitem.h"
+#include "utils/cooperationguihelper.h"
+
+#ifdef linux
+#    include <DGuiApplicationHelper>
+#    include <DPalette>
+#endif
+
+#include <QPainter>
+#include <QPainterPath>
+
+using namespace cooperation_core;
+
+// Same geometry as DeviceItem
+static constexpr int kItemWidth { 480 };
+static constexpr int kItemHeight { 90 };
+static constexpr int kItemSpacing { 10 };
+static constexpr int kItemRadius { 8 };
+static constexpr int kIconSize { 52 };
+static constexpr int kMargin { 10 };
+static constexpr int kNameWidth { 385 };
+
+DeviceListModel::DeviceListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int DeviceListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : devices.size();
+}
+
+QVariant DeviceListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= devices.size())
+        return QVariant();
+
+    const DeviceInfoPointer &info = devices.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return info->deviceName();
+    case Qt::ToolTipRole:
+        return info->ipAddress();
+    case DeviceInfoRole:
+        return QVariant::fromValue(info);
+    default:
+        return QVariant();
+    }
+}
+
+void DeviceListModel::insertDevice(int row, const DeviceInfoPointer info)
+{
+    row = qBound(0, row, devices.size());
+    beginInsertRows(QModelIndex(), row, row);
+    devices.insert(row, info);
+    reindex(row, devices.size() - 1);
+    endInsertRows();
+}
+
+void DeviceListModel::updateDevice(int row, const DeviceInfoPointer info)
+{
+    if (row < 0 || row >= devices.size())
+        return;
+
+    const QString oldIp = devices.at(row)->ipAddress();
+    if (oldIp != info->ipAddress() && rows.value(oldIp, -1) == row)
+        rows.remove(oldIp);
+    devices[row] = info;
+    rows.insert(info->ipAddress(), row);
+
+    const QModelIndex changed = index(row);
+    Q_EMIT dataChanged(changed, changed);
+}
+
+void DeviceListModel::removeDevice(int row)
+{
+    if (row < 0 || row >= devices.size())
+        return;
+
+    beginRemoveRows(QModelIndex(), row, row);
+    const QString ip = devices.takeAt(row)->ipAddress();
+    if (rows.value(ip, -1) == row)
+        rows.remove(ip);
+    reindex(row, devices.size() - 1);
+    endRemoveRows();
+}
+
+void DeviceListModel::moveDevice(int from, int to)
+{
+    if (from == to || from < 0 || from >= devices.size() || to < 0 || to >= devices.size())
+        return;
+
+    // beginMoveRows() takes the row the item is placed before
+    if (!beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to))
+        return;
+    devices.move(from, to);
+    reindex(qMin(from, to), qMax(from, to));
+    endMoveRows();
+}
+
+void DeviceListModel::clear()
+{
+    beginResetModel();
+    devices.clear();
+    rows.clear();
+    endResetModel();
+}
+
+int DeviceListModel::rowOf(const QString &ipStr) const
+{
+    return rows.value(ipStr, -1);
+}
+
+DeviceInfoPointer DeviceListModel::deviceInfo(int row) const
+{
+    if (row < 0 || row >= devices.size())
+        return nullptr;
+    return devices.at(row);
+}
+
+void DeviceListModel::reindex(int first, int last)
+{
+    for (int i = first; i <= last; ++i)
+        rows.insert(devices.at(i)->ipAddress(), i);
+}
+
+DeviceItemDelegate::DeviceItemDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+void DeviceItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const DeviceInfoPointer info = index.data(DeviceListModel::DeviceInfoRole).value<DeviceInfoPointer>();
+    if (!info)
+        return;
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+
+    const QRect rect = itemRect(option.rect);
+    QPainterPath path;
+    path.addRoundedRect(rect, kItemRadius, kItemRadius);
+    QColor background(255, 255, 255);
+    if (CooperationGuiHelper::isDarkTheme())
+        background.setRgb(255, 255, 255, static_cast<int>(255 * 0.03));
+    painter->fillPath(path, background);
+
+    const DeviceInfo::ConnectStatus status = info->connectStatus();
+    const QRect iconRect(rect.left() + kMargin, rect.top() + (rect.height() - kIconSize) / 2, kIconSize, kIconSize);
+    DeviceItem::statusIcon(status).paint(painter, iconRect);
+
+    const int textLeft = iconRect.right() + 1 + kMargin;
+    const int textWidth = rect.right() - kMargin - textLeft;
+    int top = rect.top() + kMargin;
+
+    const QFont nameFont = CooperationGuiHelper::autoFont(14, QFont::Medium);
+    const QFontMetrics nameMetrics(nameFont);
+    painter->setFont(nameFont);
+    painter->setPen(option.palette.color(QPalette::WindowText));
+    painter->drawText(QRect(textLeft, top, textWidth, nameMetrics.height()), Qt::AlignLeft | Qt::AlignVCenter,
+                      nameMetrics.elidedText(info->deviceName(), Qt::ElideMiddle, kNameWidth));
+    top += nameMetrics.height() + 2;
+
+    const QFont ipFont = CooperationGuiHelper::autoFont(12, QFont::Medium);
+    const QFontMetrics ipMetrics(ipFont);
+    painter->setFont(ipFont);
+#ifdef linux
+    painter->setPen(DTK_GUI_NAMESPACE::DGuiApplicationHelper::instance()->applicationPalette().color(DTK_GUI_NAMESPACE::DPalette::TextTips));
+#endif
+    painter->drawText(QRect(textLeft, top, textWidth, ipMetrics.height()), Qt::AlignLeft | Qt::AlignVCenter,
+                      info->ipAddress());
+    top += ipMetrics.height() + 2;
+
+    const QFont stateFont = CooperationGuiHelper::autoFont(11, QFont::Medium);
+    const QFontMetrics stateMetrics(stateFont);
+    const QString stateText = DeviceItem::statusText(status);
+    // StateLabel has 8px horizontal and 2px vertical content margins
+    const QRect stateRect(textLeft, top, stateMetrics.horizontalAdvance(stateText) + 16, stateMetrics.height() + 4);
+    painter->setFont(stateFont);
+    StateLabel::paintState(painter, stateRect, status, stateText);
+
+    painter->restore();
+}
+
+QSize DeviceItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(option)
+    Q_UNUSED(index)
+    return QSize(kItemWidth, kItemHeight + kItemSpacing);
+}
+
+QRect DeviceItemDelegate::itemRect(const QRect &rowRect)
+{
+    return QRect(rowRect.left() + qMax(0, (rowRect.width() - kItemWidth) / 2), rowRect.top(), kItemWidth, kItemHeight);
+}
+
+int DeviceItemDelegate::itemSpacing()
+{
+    return kItemSpacing;
+}
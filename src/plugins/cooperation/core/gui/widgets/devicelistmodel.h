@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DEVICELISTMODEL_H
+#define DEVICELISTMODEL_H
+
+#include "info/deviceinfo.h"
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QStyledItemDelegate>
+
+namespace cooperation_core {
+
+class DeviceListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Roles {
+        DeviceInfoRole = Qt::UserRole + 1
+    };
+
+    explicit DeviceListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void insertDevice(int row, const DeviceInfoPointer info);
+    void updateDevice(int row, const DeviceInfoPointer info);
+    void removeDevice(int row);
+    void moveDevice(int from, int to);
+    void clear();
+
+    int rowOf(const QString &ipStr) const;
+    DeviceInfoPointer deviceInfo(int row) const;
+
+private:
+    void reindex(int first, int last);
+
+    QList<DeviceInfoPointer> devices;
+    // ip -> row, kept in step with every structural change
+    QHash<QString, int> rows;
+};
+
+// Paints a device row the way DeviceItem looks, without creating a widget
+class DeviceItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit DeviceItemDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    // The item area inside a row, rows also hold the spacing below the item
+    static QRect itemRect(const QRect &rowRect);
+    static int itemSpacing();
+};
+
+}   // namespace cooperation_core
+
+#endif   // DEVICELISTMODEL_H
@@ -3,29 +3,41 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "devicelistwidget.h"
+#include "devicelistmodel.h"
+#include "utils/cooperationguihelper.h"
 
 #include "co/co.h"
 
+#include <QHBoxLayout>
 #include <QScrollBar>
 #include <QVariantMap>
 
 using namespace cooperation_core;
 
 DeviceListWidget::DeviceListWidget(QWidget *parent)
-    : QScrollArea(parent)
+    : QListView(parent)
 {
     initUI();
 }
 
 void DeviceListWidget::initUI()
 {
+    model = new DeviceListModel(this);
+    setModel(model);
+    setItemDelegate(new DeviceItemDelegate(this));
+
+    setUniformItemSizes(true);
+    setVerticalScrollMode(ScrollPerPixel);
+    setSelectionMode(NoSelection);
+    setEditTriggers(NoEditTriggers);
+    setFocusPolicy(Qt::NoFocus);
+    setMouseTracking(true);
+    setFrameShape(NoFrame);
+    viewport()->setAutoFillBackground(false);
+
     setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
     horizontalScrollBar()->setDisabled(true);
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    mainLayout = new QVBoxLayout;
-    mainLayout->setContentsMargins(0, 0, 0, 10);
-    mainLayout->setAlignment(Qt::AlignTop | Qt::AlignCenter);
-    mainLayout->setSpacing(10);
 
 #ifndef linux
     QString scrollBarStyle = "QScrollBar:vertical {"
@@ -43,122 +55,92 @@ void DeviceListWidget::initUI()
                              "}";
     verticalScrollBar()->setStyleSheet(scrollBarStyle);
     connect(verticalScrollBar(), &QScrollBar::rangeChanged, this, [this](int min, int max) {
-        if (max)
-            mainLayout->setContentsMargins(10, 0, 0, 10);
-        else
-            mainLayout->setContentsMargins(0, 0, 0, 10);
+        Q_UNUSED(min)
+        setViewportMargins(max ? 10 : 0, 0, 0, 0);
     });
-    mainLayout->setContentsMargins(0, 0, 0, 10);
-#else
-    mainLayout->setContentsMargins(0, 0, 0, 10);
 #endif
 
-    QWidget *mainWidget = new QWidget(this);
-    mainWidget->setLayout(mainLayout);
-    setWidget(mainWidget);
-    setWidgetResizable(true);
-    setFrameShape(NoFrame);
+    connect(this, &QListView::entered, this, &DeviceListWidget::onItemEntered);
+    connect(CooperationGuiHelper::instance(), &CooperationGuiHelper::themeTypeChanged,
+            viewport(), QOverload<>::of(&QWidget::update));
 }
 
-bool DeviceListWidget::event(QEvent *e)
+void DeviceListWidget::onItemEntered(const QModelIndex &index)
 {
-    if (e->type() == QEvent::MouseButtonPress) {
-        QMouseEvent *mouseEvent = static_cast<QMouseEvent *>(e);
-        if (mouseEvent->button() == Qt::LeftButton) {
-            return true;
-        }
-    }
+    if (index == hoverIndex)
+        return;
+
+    if (hoverIndex.isValid())
+        setIndexWidget(hoverIndex, nullptr);
+    hoverIndex = index;
+
+    const DeviceInfoPointer info = model->deviceInfo(index.row());
+    if (!info)
+        return;
 
-    return QScrollArea::event(e);
+    QWidget *container = new QWidget;
+    QHBoxLayout *layout = new QHBoxLayout(container);
+    layout->setContentsMargins(0, 0, 0, DeviceItemDelegate::itemSpacing());
+    DeviceItem *item = new DeviceItem(container);
+    item->setDeviceInfo(info);
+    item->setOperations(operationList);
+    layout->addWidget(item, 0, Qt::AlignHCenter | Qt::AlignTop);
+    setIndexWidget(index, container);
+}
+
+DeviceItem *DeviceListWidget::hoverItem() const
+{
+    QWidget *container = hoverIndex.isValid() ? indexWidget(hoverIndex) : nullptr;
+    return container ? container->findChild<DeviceItem *>() : nullptr;
 }
 
 void DeviceListWidget::appendItem(const DeviceInfoPointer info)
 {
-    insertItem(mainLayout->count(), info);
+    insertItem(model->rowCount(), info);
 }
 
 void DeviceListWidget::insertItem(int index, const DeviceInfoPointer info)
 {
-    DeviceItem *item = new DeviceItem(this);
-    item->setDeviceInfo(info);
-    item->setOperations(operationList);
-
-    mainLayout->insertWidget(index, item);
+    model->insertDevice(index, info);
 }
 
 void DeviceListWidget::updateItem(int index, const DeviceInfoPointer info)
 {
-    QLayoutItem *item = mainLayout->itemAt(index);
-    DeviceItem *devItem = qobject_cast<DeviceItem *>(item->widget());
-    if (!devItem) {
+    if (index < 0 || index >= model->rowCount()) {
         LOG << "Can not find this item, index: " << index << " ip address: " << info->ipAddress().toStdString();
         return;
     }
 
-    devItem->setDeviceInfo(info);
+    model->updateDevice(index, info);
+    if (hoverIndex.row() == index) {
+        if (DeviceItem *item = hoverItem())
+            item->setDeviceInfo(info);
+    }
 }
 
 void DeviceListWidget::removeItem(int index)
 {
-    QLayoutItem *item = mainLayout->takeAt(index);
-    if (!item)
-        return;
-    QWidget *w = item->widget();
-    if (w) {
-        w->setParent(nullptr);
-        w->deleteLater();
-    }
-
-    delete item;
+    model->removeDevice(index);
 }
 
 void DeviceListWidget::moveItem(int srcIndex, int toIndex)
 {
-    if (srcIndex == toIndex)
-        return;
-
-    QLayoutItem *item = mainLayout->takeAt(srcIndex);
-    if (!item)
-        return;
-
-    mainLayout->insertItem(toIndex, item);
+    model->moveDevice(srcIndex, toIndex);
 }
 
 int DeviceListWidget::indexOf(const QString &ipStr)
 {
-    const int count = mainLayout->count();
-    for (int i = 0; i != count; ++i) {
-        QLayoutItem *item = mainLayout->itemAt(i);
-        DeviceItem *w = qobject_cast<DeviceItem *>(item->widget());
-        if (!w)
-            continue;
-
-        if (w->deviceInfo()->ipAddress() == ipStr)
-            return i;
-    }
-
-    return -1;
+    return model->rowOf(ipStr);
 }
 
 DeviceInfoPointer DeviceListWidget::findDeviceInfo(const QString &ipStr)
 {
-    const int count = mainLayout->count();
-    for (int i = 0; i != count; ++i) {
-        QLayoutItem *item = mainLayout->itemAt(i);
-        DeviceItem *w = qobject_cast<DeviceItem *>(item->widget());
-        if (!w)
-            continue;
-
-        if (w->deviceInfo()->ipAddress() == ipStr)
-            return w->deviceInfo();
-    }
-
-    return nullptr;
+    return model->deviceInfo(model->rowOf(ipStr));
 }
 
 int DeviceListWidget::itemCount()
 {
-    return mainLayout->count();
+    return model->rowCount();
 }
 
 void DeviceListWidget::addItemOperation(const QVariantMap &map)
@@ -178,8 +160,5 @@ void DeviceListWidget::addItemOperation(const QVariantMap &map)
 
 void DeviceListWidget::clear()
 {
-    const int count = mainLayout->count();
-    for (int i = 0; i != count; ++i) {
-        removeItem(0);
-    }
+    model->clear();
 }
@@ -8,12 +8,13 @@
 #include "global_defines.h"
 #include "deviceitem.h"
 
-#include <QScrollArea>
-#include <QVBoxLayout>
-#include <QMouseEvent>
+#include <QListView>
+#include <QPersistentModelIndex>
+
 namespace cooperation_core {
 
-class DeviceListWidget : public QScrollArea
+class DeviceListModel;
+class DeviceListWidget : public QListView
 {
     Q_OBJECT
 public:
@@ -32,15 +33,20 @@ public:
 
     void clear();
 
+private Q_SLOTS:
+    void onItemEntered(const QModelIndex &index);
+
 private:
     void initUI();
+    DeviceItem *hoverItem() const;
 
 private:
-    QVBoxLayout *mainLayout { nullptr };
+    DeviceListModel *model { nullptr };
     QList<DeviceItem::Operation> operationList;
 
-protected:
-    bool event(QEvent *e) override;
+    // Rows are painted by the delegate, only the row under the mouse holds
+    // a real DeviceItem so its buttons can be used
+    QPersistentModelIndex hoverIndex;
 };
 
 }   // namespace cooperation_core
@@ -94,11 +94,8 @@ void WorkspaceWidgetPrivate::initConnect()
     connect(this, &WorkspaceWidgetPrivate::devicesRemoved, sortFilterWorker.data(), &SortFilterWorker::removeDevice, Qt::QueuedConnection);
     connect(this, &WorkspaceWidgetPrivate::filterDevice, sortFilterWorker.data(), &SortFilterWorker::filterDevice, Qt::QueuedConnection);
     connect(this, &WorkspaceWidgetPrivate::clearDevice, sortFilterWorker.data(), &SortFilterWorker::clear, Qt::QueuedConnection);
-    connect(sortFilterWorker.data(), &SortFilterWorker::sortFilterResult, this, &WorkspaceWidgetPrivate::onSortFilterResult, Qt::QueuedConnection);
+    connect(sortFilterWorker.data(), &SortFilterWorker::devicesChanged, this, &WorkspaceWidgetPrivate::onDevicesChanged, Qt::QueuedConnection);
     connect(sortFilterWorker.data(), &SortFilterWorker::filterFinished, this, &WorkspaceWidgetPrivate::onFilterFinished, Qt::QueuedConnection);
-    connect(sortFilterWorker.data(), &SortFilterWorker::deviceRemoved, this, &WorkspaceWidgetPrivate::onDeviceRemoved, Qt::QueuedConnection);
-    connect(sortFilterWorker.data(), &SortFilterWorker::deviceUpdated, this, &WorkspaceWidgetPrivate::onDeviceUpdated, Qt::QueuedConnection);
-    connect(sortFilterWorker.data(), &SortFilterWorker::deviceMoved, this, &WorkspaceWidgetPrivate::onDeviceMoved, Qt::QueuedConnection);
 }
 
 void WorkspaceWidgetPrivate::onSearchValueChanged(const QString &text)
@@ -106,7 +103,7 @@ void WorkspaceWidgetPrivate::onSearchValueChanged(const QString &text)
     if (currentPage == WorkspaceWidget::kNoNetworkWidget)
         return;
 
-    dlWidget->clear();
+    // The worker answers with the rows to add and remove
     Q_EMIT filterDevice(text);
 }
 
@@ -123,10 +120,31 @@ void WorkspaceWidgetPrivate::onSearchDevice()
     });
 }
 
-void WorkspaceWidgetPrivate::onSortFilterResult(int index, const DeviceInfoPointer info)
-{
-    q->switchWidget(WorkspaceWidget::kDeviceListWidget);
-    dlWidget->insertItem(index, info);
+void WorkspaceWidgetPrivate::onDevicesChanged(const QList<DeviceChange> &changes)
+{
+    bool removed = false;
+    for (const DeviceChange &change : changes) {
+        switch (change.type) {
+        case DeviceChange::Inserted:
+            q->switchWidget(WorkspaceWidget::kDeviceListWidget);
+            dlWidget->insertItem(change.to, change.info);
+            break;
+        case DeviceChange::Removed:
+            dlWidget->removeItem(change.from);
+            removed = true;
+            break;
+        case DeviceChange::Updated:
+            dlWidget->updateItem(change.from, change.info);
+            break;
+        case DeviceChange::Moved:
+            dlWidget->updateItem(change.from, change.info);
+            dlWidget->moveItem(change.from, change.to);
+            break;
+        }
+    }
+
+    if (removed && dlWidget->itemCount() == 0)
+        q->switchWidget(WorkspaceWidget::kNoResultWidget);
 }
 
 void WorkspaceWidgetPrivate::onFilterFinished()
@@ -141,24 +159,6 @@ void WorkspaceWidgetPrivate::onFilterFinished()
     }
 }
 
-void WorkspaceWidgetPrivate::onDeviceRemoved(int index)
-{
-    dlWidget->removeItem(index);
-    if (dlWidget->itemCount() == 0)
-        q->switchWidget(WorkspaceWidget::kNoResultWidget);
-}
-
-void WorkspaceWidgetPrivate::onDeviceUpdated(int index, const DeviceInfoPointer info)
-{
-    dlWidget->updateItem(index, info);
-}
-
-void WorkspaceWidgetPrivate::onDeviceMoved(int from, int to, const DeviceInfoPointer info)
-{
-    dlWidget->updateItem(from, info);
-    dlWidget->moveItem(from, to);
-}
-
 WorkspaceWidget::WorkspaceWidget(QWidget *parent)
     : QWidget(parent),
       d(new WorkspaceWidgetPrivate(this))
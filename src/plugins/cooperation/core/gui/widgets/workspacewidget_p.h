@@ -36,11 +36,8 @@ public:
 
 public Q_SLOTS:
     void onSearchValueChanged(const QString &text);
-    void onSortFilterResult(int index, const DeviceInfoPointer info);
+    void onDevicesChanged(const QList<DeviceChange> &changes);
     void onFilterFinished();
-    void onDeviceRemoved(int index);
-    void onDeviceUpdated(int index, const DeviceInfoPointer info);
-    void onDeviceMoved(int from, int to, const DeviceInfoPointer info);
     void onSearchDevice();
 
 Q_SIGNALS:
@@ -181,6 +181,26 @@ DeviceInfoPointer DeviceInfo::fromVariantMap(const QVariantMap &map)
     return info;
 }
 
+// Same as fromVariantMap, without building the intermediate map
+DeviceInfoPointer DeviceInfo::fromJsonObject(const QJsonObject &obj)
+{
+    if (obj.isEmpty())
+        return {};
+
+    DeviceInfoPointer info = DeviceInfoPointer(new DeviceInfo);
+    info->setIpAddress(obj.value(IPAddress).toString());
+    info->setDeviceName(obj.value(AppSettings::DeviceNameKey).toString());
+    info->setTransMode(static_cast<TransMode>(obj.value(AppSettings::TransferModeKey).toVariant().toInt()));
+    info->setDiscoveryMode(static_cast<DiscoveryMode>(obj.value(AppSettings::DiscoveryModeKey).toVariant().toInt()));
+    info->setLinkMode(static_cast<LinkMode>(obj.value(AppSettings::LinkDirectionKey).toVariant().toInt()));
+    info->setClipboardShared(obj.value(AppSettings::ClipboardShareKey).toVariant().toBool());
+    info->setPeripheralShared(obj.value(AppSettings::PeripheralShareKey).toVariant().toBool());
+    info->setCooperationEnable(obj.value(AppSettings::CooperationEnabled).toVariant().toBool());
+    info->setOsType(static_cast<BaseUtils::OS_TYPE>(obj.value(OSType).toVariant().toInt()));
+
+    return info;
+}
+
 DeviceInfo &DeviceInfo::operator=(const DeviceInfo &info)
 {
     d->deviceName = info.d->deviceName;
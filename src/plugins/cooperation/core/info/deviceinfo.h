@@ -7,6 +7,7 @@
 
 #include "base/baseutils.h"
 
+#include <QJsonObject>
 #include <QMetaType>
 #include <QSharedPointer>
 
@@ -83,6 +84,7 @@ public:
 
     QVariantMap toVariantMap();
     static DeviceInfoPointer fromVariantMap(const QVariantMap &map);
+    static DeviceInfoPointer fromJsonObject(const QJsonObject &obj);
 
     virtual DeviceInfo &operator=(const DeviceInfo &info);
     virtual bool operator==(const DeviceInfo &info) const;
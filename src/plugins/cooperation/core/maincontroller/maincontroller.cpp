@@ -12,27 +12,20 @@
 
 #include <QNetworkInterface>
 #include <QStandardPaths>
-#include <QJsonDocument>
 #include <QtConcurrent>
 #include <QHostInfo>
 #include <QDir>
 
-using ConnectHistory = QMap<QString, QString>;
-Q_GLOBAL_STATIC(ConnectHistory, connectHistory)
-
 using namespace cooperation_core;
 
 MainController::MainController(QObject *parent)
     : QObject(parent)
 {
+    qRegisterMetaType<DeviceInfoPointer>();
+
     networkMonitorTimer = new QTimer(this);
     networkMonitorTimer->setInterval(1000);
 
-    *connectHistory = HistoryManager::instance()->getConnectHistory();
-    connect(HistoryManager::instance(), &HistoryManager::connectHistoryUpdated, this, [] {
-        *connectHistory = HistoryManager::instance()->getConnectHistory();
-    });
-
     initConnect();
 }
 
@@ -48,60 +41,86 @@ void MainController::checkNetworkState()
     if (isConnected != isOnline) {
         isOnline = isConnected;
         Q_EMIT onlineStateChanged(isConnected);
+
+        // The list is cleared while offline, fetch it again once back
+        onlineIps.clear();
+        if (isConnected)
+            resync();
+        else
+            synced = false;
     }
 }
 
-void MainController::updateDeviceList(const QString &ip, const QString &connectedIp, int osType, const QString &info, bool isOnline)
+void MainController::onPeerChanged(int version, const QString &ip, const DeviceInfoPointer &info, bool isOnline)
 {
+    if (synced) {
+        // Already part of the last device list
+        if (version <= peerVersion)
+            return;
+
+        // Some changes were lost, fetch the whole list again
+        if (version > peerVersion + 1) {
+            WLOG << "discovery version jumped from " << peerVersion << " to " << version;
+            resync();
+        }
+    }
+    peerVersion = qMax(peerVersion, version);
+
     if (!this->isOnline)
         return;
 
     if (isOnline) {
-        QJsonParseError error;
-        auto doc = QJsonDocument::fromJson(info.toLocal8Bit(), &error);
-        if (error.error != QJsonParseError::NoError)
+        if (!info)
             return;
 
-        auto map = doc.toVariant().toMap();
-        if (!map.contains("DeviceName"))
-            return;
+        onlineIps.insert(ip);
+        // 处理设备的共享属性发生变化情况
+        CooperationManager::instance()->checkAndProcessShare(info);
+        Q_EMIT deviceOnline({ info });
+        return;
+    }
 
-        map.insert("IPAddress", ip);
-        map.insert("OSType", osType);
-        auto devInfo = DeviceInfo::fromVariantMap(map);
-        if (devInfo->discoveryMode() == DeviceInfo::DiscoveryMode::Everyone) {
-            if (connectedIp == CooperationUtil::localIPAddress())
-                devInfo->setConnectStatus(DeviceInfo::Connected);
+    setDeviceOffline(ip);
+}
 
-            // 处理设备的共享属性发生变化情况
-            CooperationManager::instance()->checkAndProcessShare(devInfo);
-            Q_EMIT deviceOnline({ devInfo });
+void MainController::onDiscoveryFinished(const QList<DeviceInfoPointer> &infoList, int version)
+{
+    syncPending = false;
+    if (version >= 0) {
+        // A newer change was applied before this list arrived
+        if (version < peerVersion && isOnline) {
+            resync();
             return;
         }
+
+        peerVersion = version;
+        synced = true;
+
+        QSet<QString> ips;
+        for (const auto &info : infoList)
+            ips.insert(info->ipAddress());
+
+        // Devices that went away while the list was out of sync
+        const auto lostIps = onlineIps - ips;
+        for (const auto &ip : lostIps)
+            setDeviceOffline(ip);
+        onlineIps = ips;
     }
 
-    // 更新设备状态为离线状态
-    if (connectHistory->contains(ip)) {
-        DeviceInfoPointer info(new DeviceInfo(ip, connectHistory->value(ip)));
-        info->setConnectStatus(DeviceInfo::Offline);
-        updateDeviceState(info);
+    if (!isRunning) {
+        if (!infoList.isEmpty())
+            Q_EMIT deviceOnline(infoList);
         return;
     }
 
-    Q_EMIT deviceOffline(ip);
-}
-
-void MainController::onDiscoveryFinished(const QList<DeviceInfoPointer> &infoList)
-{
-    if (infoList.isEmpty() && connectHistory->isEmpty()) {
+    isRunning = false;
+    if (infoList.isEmpty() && HistoryManager::instance()->getConnectHistory().isEmpty()) {
         Q_EMIT discoveryFinished(false);
-        isRunning = false;
         return;
     }
 
     Q_EMIT deviceOnline(infoList);
     Q_EMIT discoveryFinished(true);
-    isRunning = false;
 }
 
 MainController *MainController::instance()
@@ -120,6 +139,7 @@ void MainController::start()
 
     Q_EMIT startDiscoveryDevice();
     isRunning = true;
+    onlineIps.clear();
 
     // 延迟1s，为了展示发现界面
     QTimer::singleShot(1000, this, &MainController::discoveryDevice);
@@ -129,6 +149,13 @@ void MainController::stop()
 {
 }
 
+void MainController::resetDiscovery()
+{
+    peerVersion = 0;
+    synced = false;
+    syncPending = false;
+}
+
 void MainController::updateDeviceState(const DeviceInfoPointer info)
 {
     Q_EMIT deviceOnline({ info });
@@ -143,8 +170,9 @@ void MainController::discoveryDevice()
     }
 
     QList<DeviceInfoPointer> offlineDevList;
-    auto iter = connectHistory->begin();
-    for (; iter != connectHistory->end(); ++iter) {
+    const auto &connectHistory = HistoryManager::instance()->getConnectHistory();
+    auto iter = connectHistory.begin();
+    for (; iter != connectHistory.end(); ++iter) {
         DeviceInfoPointer info(new DeviceInfo(iter.key(), iter.value()));
         info->setConnectStatus(DeviceInfo::Offline);
         offlineDevList << info;
@@ -153,5 +181,33 @@ void MainController::discoveryDevice()
     if (!offlineDevList.isEmpty())
         deviceOnline(offlineDevList);
 
+    synced = false;
+    syncPending = true;
+    CooperationUtil::instance()->asyncDiscoveryDevice();
+}
+
+void MainController::resync()
+{
+    if (syncPending || !isOnline)
+        return;
+
+    synced = false;
+    syncPending = true;
     CooperationUtil::instance()->asyncDiscoveryDevice();
 }
+
+void MainController::setDeviceOffline(const QString &ip)
+{
+    onlineIps.remove(ip);
+
+    // 更新设备状态为离线状态
+    const auto &devName = HistoryManager::instance()->connectHistoryName(ip);
+    if (!devName.isEmpty()) {
+        DeviceInfoPointer info(new DeviceInfo(ip, devName));
+        info->setConnectStatus(DeviceInfo::Offline);
+        updateDeviceState(info);
+        return;
+    }
+
+    Q_EMIT deviceOffline(ip);
+}
@@ -11,6 +11,7 @@
 #include <QObject>
 #include <QTimer>
 #include <QFuture>
+#include <QSet>
 
 namespace cooperation_core {
 
@@ -27,6 +28,7 @@ public:
 public Q_SLOTS:
     void start();
     void stop();
+    void resetDiscovery();
 
 Q_SIGNALS:
     void onlineStateChanged(bool isOnline);
@@ -38,8 +40,8 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void checkNetworkState();
-    void updateDeviceList(const QString &ip, const QString &connectedIp, int osType, const QString &info, bool isOnline);
-    void onDiscoveryFinished(const QList<DeviceInfoPointer> &infoList);
+    void onPeerChanged(int version, const QString &ip, const DeviceInfoPointer &info, bool isOnline);
+    void onDiscoveryFinished(const QList<DeviceInfoPointer> &infoList, int version);
     void onAppAttributeChanged(const QString &group, const QString &key, const QVariant &value);
 
 private:
@@ -49,12 +51,20 @@ private:
     void initConnect();
     void registDeviceInfo();
     void discoveryDevice();
+    void resync();
+    void setDeviceOffline(const QString &ip);
 
 private:
     QTimer *networkMonitorTimer { nullptr };
 
     bool isRunning { false };
     bool isOnline { true };
+
+    // Daemon discovery version the device list has caught up to
+    int peerVersion { 0 };
+    bool synced { false };
+    bool syncPending { false };
+    QSet<QString> onlineIps;
 };
 
 }   // namespace cooperation_core
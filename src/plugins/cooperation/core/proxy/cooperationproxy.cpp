@@ -25,9 +25,6 @@
 #include <QProgressDialog>
 #include <QDesktopServices>
 
-using TransHistoryInfo = QMap<QString, QString>;
-Q_GLOBAL_STATIC(TransHistoryInfo, transHistory)
-
 using namespace deepin_cross;
 using namespace cooperation_core;
 
@@ -104,7 +101,6 @@ void CooperationProxy::onTransJobStatusChanged(int id, int result, const QString
             auto ip = msg.mid(startPos + 1, endPos - startPos - 1);
             recvFilesSavePath = msg;
 
-            transHistory->insert(ip, recvFilesSavePath);
             HistoryManager::instance()->writeIntoTransHistory(ip, recvFilesSavePath);
         }
 
@@ -23,6 +23,8 @@
 #include <QTime>
 #include <QTimer>
 
+#include <cmath>
+
 #ifdef linux
 #    include "base/reportlog/reportlogmanager.h"
 
@@ -36,13 +38,16 @@ Q_DECLARE_METATYPE(ButtonStateCallback)
 Q_DECLARE_METATYPE(ClickedCallback)
 
 inline constexpr int TransferJobStartId = 1000;
+// One frame at 60 Hz, progress is never rendered more often than this
+inline constexpr int ProgressFrameInterval = 16;
+// Time constant of the speed smoothing, in milliseconds
+inline constexpr double SpeedSmoothingMs = 3000;
+// Largest remaining time shown, QTime wraps at 24 hours
+inline constexpr int64_t MaxRemainSeconds = 24 * 3600 - 1;
 
 inline constexpr char HistoryButtonId[] { "history-button" };
 inline constexpr char TransferButtonId[] { "transfer-button" };
 
-using TransHistoryInfo = QMap<QString, QString>;
-Q_GLOBAL_STATIC(TransHistoryInfo, transHistory)
-
 #ifdef linux
 inline constexpr char Khistory[] { "history" };
 inline constexpr char Ksend[] { "send" };
@@ -58,14 +63,51 @@ TransferHelperPrivate::TransferHelperPrivate(TransferHelper *qq)
     : QObject(qq),
       q(qq)
 {
-    *transHistory = HistoryManager::instance()->getTransHistory();
-    connect(HistoryManager::instance(), &HistoryManager::transHistoryUpdated, q,
-            [] {
-                *transHistory = HistoryManager::instance()->getTransHistory();
-            });
-
     confirmTimer.setInterval(10 * 1000);
     connect(&confirmTimer, &QTimer::timeout, this, &TransferHelperPrivate::onVerifyTimeout);
+
+    progressTimer.setSingleShot(true);
+    progressTimer.setInterval(ProgressFrameInterval);
+    connect(&progressTimer, &QTimer::timeout, this, &TransferHelperPrivate::renderProgress);
+}
+
+void TransferHelperPrivate::TransferInfo::update(int64_t total, int64_t current, int64_t millisec)
+{
+    totalSize = total;
+    transferSize = current;
+    maxTimeMs = millisec;
+    dirty = true;
+
+    const int64_t elapsed = millisec - lastTimeMs;
+    if (elapsed <= 0 || current < lastSize)
+        return;
+
+    // 指数加权平均，采样间隔越长新速度的权重越大
+    const double sample = static_cast<double>(current - lastSize) / elapsed;
+    const double weight = speed > 0 ? 1 - std::exp(-elapsed / SpeedSmoothingMs) : 1;
+    speed += weight * (sample - speed);
+    lastSize = current;
+    lastTimeMs = millisec;
+}
+
+int64_t TransferHelperPrivate::TransferInfo::remainSeconds() const
+{
+    if (transferSize >= totalSize)
+        return 0;
+
+    // 传输停滞时速度趋近于零，结果需要截断
+    double seconds = 0;
+    if (speed > 0) {
+        seconds = (totalSize - transferSize) / speed / 1000;
+    } else {
+        // no speed sample yet, use the average so far
+        if (transferSize <= 0)
+            return -1;
+        seconds = static_cast<double>(totalSize - transferSize) / transferSize * maxTimeMs / 1000;
+    }
+    if (!(seconds < MaxRemainSeconds))
+        return MaxRemainSeconds;
+    return static_cast<int64_t>(seconds);
 }
 
 TransferHelperPrivate::~TransferHelperPrivate()
@@ -193,6 +235,9 @@ void TransferHelperPrivate::handleCancelTransfer()
 
 void TransferHelperPrivate::transferResult(bool result, const QString &msg)
 {
+    // a pending frame must not switch back to the progress page
+    progressTimer.stop();
+    transferInfo.dirty = false;
     transDialog()->switchResultPage(result, msg);
     reportTransferResult(result);
 }
@@ -204,6 +249,29 @@ void TransferHelperPrivate::updateProgress(int value, const QString &remainTime)
     transDialog()->updateProgress(value, remainTime);
 }
 
+void TransferHelperPrivate::renderProgress()
+{
+    if (!transferInfo.dirty)
+        return;
+    transferInfo.dirty = false;
+
+    if (transferInfo.totalSize <= 0)
+        return;
+
+    // 计算整体进度和预估剩余时间
+    int progressValue = static_cast<int>(transferInfo.transferSize * 100 / transferInfo.totalSize);
+    if (progressValue <= 0)
+        return;
+    progressValue = qMin(progressValue, 100);
+
+    const int64_t remainTime = transferInfo.remainSeconds();
+    if (remainTime < 0)
+        return;
+
+    LOG_IF(FLG_log_detail) << "progressbar: " << progressValue << " remain_time=" << remainTime;
+    updateProgress(progressValue, QTime(0, 0, 0).addSecs(static_cast<int>(remainTime)).toString("hh:mm:ss"));
+}
+
 void TransferHelperPrivate::reportTransferResult(bool result)
 {
 #ifdef linux
@@ -312,10 +380,11 @@ void TransferHelper::buttonClicked(const QString &id, const DeviceInfoPointer in
 
         TransferHelper::instance()->sendFiles(info->ipAddress(), info->deviceName(), selectedFiles);
     } else if (id == HistoryButtonId) {
-        if (!transHistory->contains(info->ipAddress()))
+        const auto &savePath = HistoryManager::instance()->transHistoryPath(info->ipAddress());
+        if (savePath.isEmpty())
             return;
 
-        QDesktopServices::openUrl(QUrl::fromLocalFile(transHistory->value(info->ipAddress())));
+        QDesktopServices::openUrl(QUrl::fromLocalFile(savePath));
     }
 }
 
@@ -336,10 +405,11 @@ bool TransferHelper::buttonVisible(const QString &id, const DeviceInfoPointer in
         if (qApp->property("onlyTransfer").toBool())
             return false;
 
-        if (!transHistory->contains(info->ipAddress()))
+        const auto &savePath = HistoryManager::instance()->transHistoryPath(info->ipAddress());
+        if (savePath.isEmpty())
             return false;
 
-        bool exists = QFile::exists(transHistory->value(info->ipAddress()));
+        bool exists = QFile::exists(savePath);
         if (!exists)
             HistoryManager::instance()->removeTransHistory(info->ipAddress());
 
@@ -410,29 +480,12 @@ void TransferHelper::onFileTransStatusChanged(const QString &status)
     ipc::FileStatus param;
     param.from_json(statusJson);
 
-    d->transferInfo.totalSize = param.total;
-    d->transferInfo.transferSize = param.current;
-    d->transferInfo.maxTimeMs = param.millisec;
-
-    // 计算整体进度和预估剩余时间
-    double value = static_cast<double>(d->transferInfo.transferSize) / d->transferInfo.totalSize;
-    int progressValue = static_cast<int>(value * 100);
-    QTime time(0, 0, 0);
-    int remain_time;
-    if (progressValue <= 0) {
-        return;
-    } else if (progressValue >= 100) {
-        progressValue = 100;
-        remain_time = 0;
-    } else {
-        remain_time = (d->transferInfo.maxTimeMs * 100 / progressValue - d->transferInfo.maxTimeMs) / 1000;
-    }
-    time = time.addSecs(remain_time);
-
-    LOG_IF(FLG_log_detail) << "progressbar: " << progressValue << " remain_time=" << remain_time;
+    d->transferInfo.update(param.total, param.current, param.millisec);
     LOG_IF(FLG_log_detail) << "totalSize: " << d->transferInfo.totalSize << " transferSize=" << d->transferInfo.transferSize;
 
-    d->updateProgress(progressValue, time.toString("hh:mm:ss"));
+    // 多条消息合并为一次界面刷新
+    if (!d->progressTimer.isActive())
+        d->progressTimer.start();
 }
 
 void TransferHelper::waitForConfirm()
@@ -31,12 +31,27 @@ public:
         int64_t transferSize = 0;   // 当前传输量
         int64_t maxTimeMs = 0;   // 耗时
 
+        // 平滑后的传输速度(字节/毫秒)，用于估算剩余时间
+        double speed = 0;
+        int64_t lastSize = 0;
+        int64_t lastTimeMs = 0;
+        // a sample arrived since the last render
+        bool dirty = false;
+
         void clear()
         {
             totalSize = 0;
             transferSize = 0;
             maxTimeMs = 0;
+            speed = 0;
+            lastSize = 0;
+            lastTimeMs = 0;
+            dirty = false;
         }
+
+        void update(int64_t total, int64_t current, int64_t millisec);
+        // seconds, -1 if not enough data yet
+        int64_t remainSeconds() const;
     };
 
     explicit TransferHelperPrivate(TransferHelper *qq);
@@ -57,6 +72,7 @@ public:
 
 public Q_SLOTS:
     void onVerifyTimeout();
+    void renderProgress();
 
 private:
     TransferHelper *q;
@@ -70,6 +86,8 @@ private:
     uint recvNotifyId { 0 };
 
     QTimer confirmTimer;
+    // Progress messages only update transferInfo, the dialog is refreshed once per frame
+    QTimer progressTimer;
     bool isTransTimeout = false;
     QString recvFilesSavePath;
 };
@@ -121,3 +121,26 @@ void CooperationGuiHelper::setAutoFont(QWidget *widget, int size, int weight)
     widget->setFont(font);
 #endif
 }
+
+QFont CooperationGuiHelper::autoFont(int size, int weight)
+{
+#ifdef linux
+    switch (size) {
+    case 16:
+        return DFontSizeManager::instance()->get(DFontSizeManager::T5, weight);
+    case 14:
+        return DFontSizeManager::instance()->get(DFontSizeManager::T6, weight);
+    case 12:
+        return DFontSizeManager::instance()->get(DFontSizeManager::T8, weight);
+    case 11:
+        return DFontSizeManager::instance()->get(DFontSizeManager::T9, weight);
+    default:
+        return DFontSizeManager::instance()->get(DFontSizeManager::T6, weight);
+    }
+#else
+    QFont font;
+    font.setPixelSize(size);
+    font.setWeight(weight);
+    return font;
+#endif
+}
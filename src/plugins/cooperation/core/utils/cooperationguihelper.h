@@ -24,6 +24,8 @@ public:
 
     static void setLabelFont(QLabel *label, int pointSize, int minpointSize, int weight);
     static void setAutoFont(QWidget *widget, int size, int weight);
+    // The font setAutoFont() applies, for text painted without a widget
+    static QFont autoFont(int size, int weight);
 
 Q_SIGNALS:
     void themeTypeChanged();
@@ -31,6 +31,9 @@ DWIDGET_USE_NAMESPACE
 #endif
 using namespace cooperation_core;
 
+// Upper bound of remembered peers, the cache is simply reset when reached
+static constexpr int kMaxParsedPeers = 1024;
+
 CooperationUtilPrivate::CooperationUtilPrivate(CooperationUtil *qq)
     : q(qq)
 {
@@ -123,36 +126,36 @@ void CooperationUtilPrivate::localIPCStart()
                 co::Json obj = json::parse(param.msg);
                 NodeInfo nodeInfo;
                 nodeInfo.from_json(obj);
-                if (nodeInfo.apps.empty() && !param.result) {
-                    q->metaObject()->invokeMethod(MainController::instance(),
-                                                  "updateDeviceList",
-                                                  Qt::QueuedConnection,
-                                                  Q_ARG(QString, QString(nodeInfo.os.ipv4.c_str())),
-                                                  Q_ARG(QString, QString("")),
-                                                  Q_ARG(int, nodeInfo.os.os_type),
-                                                  Q_ARG(QString, QString("")),
-                                                  Q_ARG(bool, param.result));
-                    break;
-                }
-
-                for (const auto &appInfo : nodeInfo.apps) {
-                    // 上线，非跨端应用无需处理
-                    if (param.result && appInfo.appname.compare(CooperRegisterName) != 0)
-                        continue;
 
+                // Parse here, the GUI thread only gets the finished device
+                bool isOnline = param.result;
+                DeviceInfoPointer devInfo { nullptr };
+                if (isOnline) {
+                    devInfo = parseNodeInfo(nodeInfo);
+                    if (devInfo && devInfo->discoveryMode() != DeviceInfo::DiscoveryMode::Everyone) {
+                        devInfo.reset();
+                        isOnline = false;
+                    } else if (devInfo && QString(nodeInfo.os.share_connect_ip.c_str()) == CooperationUtil::localIPAddress()) {
+                        devInfo->setConnectStatus(DeviceInfo::Connected);
+                    }
+                } else {
                     // 下线，跨端应用未下线
-                    if (!param.result && appInfo.appname.compare(CooperRegisterName) == 0)
-                        continue;
-
-                    q->metaObject()->invokeMethod(MainController::instance(),
-                                                  "updateDeviceList",
-                                                  Qt::QueuedConnection,
-                                                  Q_ARG(QString, QString(nodeInfo.os.ipv4.c_str())),
-                                                  Q_ARG(QString, QString(nodeInfo.os.share_connect_ip.c_str())),
-                                                  Q_ARG(int, nodeInfo.os.os_type),
-                                                  Q_ARG(QString, QString(appInfo.json.c_str())),
-                                                  Q_ARG(bool, param.result));
+                    for (const auto &appInfo : nodeInfo.apps) {
+                        if (appInfo.appname.compare(CooperRegisterName) == 0) {
+                            isOnline = true;
+                            break;
+                        }
+                    }
                 }
+
+                // Always delivered, the version keeps the device list in sync
+                q->metaObject()->invokeMethod(MainController::instance(),
+                                              "onPeerChanged",
+                                              Qt::QueuedConnection,
+                                              Q_ARG(int, param.id),
+                                              Q_ARG(QString, QString(nodeInfo.os.ipv4.c_str())),
+                                              Q_ARG(DeviceInfoPointer, devInfo),
+                                              Q_ARG(bool, isOnline));
             } break;
             case FRONT_CONNECT_CB: {
                 ipc::GenericResult param;
@@ -205,6 +208,10 @@ void CooperationUtilPrivate::localIPCStart()
             } break;
             case FRONT_SERVER_ONLINE:
                 backendOk = pingBackend();
+                // The backend restarted, its discovery version starts over
+                q->metaObject()->invokeMethod(MainController::instance(),
+                                              "resetDiscovery",
+                                              Qt::QueuedConnection);
                 q->metaObject()->invokeMethod(MainController::instance(),
                                               "start",
                                               Qt::QueuedConnection);
@@ -280,44 +287,56 @@ void CooperationUtilPrivate::localIPCStart()
     rpc::Server().add_service(frontendimp).start("0.0.0.0", onlyTransfer ? UNI_IPC_FRONTEND_TRANSFER_PORT : UNI_IPC_FRONTEND_COOPERATION_PORT, "/frontend", "", "");
 }
 
-QList<DeviceInfoPointer> CooperationUtilPrivate::parseDeviceInfo(const co::Json &obj)
+QList<DeviceInfoPointer> CooperationUtilPrivate::parseDeviceInfo(NodeList &nodeList)
 {
-    NodeList nodeList;
-    nodeList.from_json(obj);
-
     auto lastInfo = nodeList.peers.pop_back();
     QList<DeviceInfoPointer> devInfoList;
     for (const auto &node : nodeList.peers) {
-        DeviceInfoPointer devInfo { nullptr };
-        for (const auto &app : node.apps) {
-            if (app.appname != CooperRegisterName)
-                continue;
+        auto devInfo = parseNodeInfo(node);
+        if (!devInfo || !devInfo->isValid() || devInfo->discoveryMode() != DeviceInfo::DiscoveryMode::Everyone)
+            continue;
 
-            QJsonParseError error;
-            auto doc = QJsonDocument::fromJson(app.json.c_str(), &error);
-            if (error.error != QJsonParseError::NoError)
-                continue;
+        if (lastInfo.os.share_connect_ip == node.os.ipv4)
+            devInfo->setConnectStatus(DeviceInfo::Connected);
+        else
+            devInfo->setConnectStatus(DeviceInfo::Connectable);
 
-            auto map = doc.toVariant().toMap();
-            if (!map.contains(AppSettings::DeviceNameKey))
-                continue;
+        devInfoList << devInfo;
+    }
 
-            map.insert("IPAddress", node.os.ipv4.c_str());
-            map.insert("OSType", node.os.os_type);
-            devInfo = DeviceInfo::fromVariantMap(map);
-            if (lastInfo.os.share_connect_ip == node.os.ipv4)
-                devInfo->setConnectStatus(DeviceInfo::Connected);
-            else
-                devInfo->setConnectStatus(DeviceInfo::Connectable);
+    return devInfoList;
+}
+
+DeviceInfoPointer CooperationUtilPrivate::parseNodeInfo(const NodeInfo &node)
+{
+    for (const auto &app : node.apps) {
+        if (app.appname != CooperRegisterName)
+            continue;
+
+        const QString ip(node.os.ipv4.c_str());
+        {
+            QMutexLocker lk(&parsedLock);
+            auto iter = parsedPeers.constFind(ip);
+            if (iter != parsedPeers.constEnd() && iter->json == app.json)
+                return iter->info ? DeviceInfoPointer(new DeviceInfo(*iter->info)) : nullptr;
+        }
 
-            break;
+        DeviceInfoPointer info;
+        QJsonParseError error;
+        auto doc = QJsonDocument::fromJson(QByteArray::fromRawData(app.json.data(), static_cast<int>(app.json.size())), &error);
+        if (error.error == QJsonParseError::NoError && doc.object().contains(AppSettings::DeviceNameKey)) {
+            info = DeviceInfo::fromJsonObject(doc.object());
+            info->setIpAddress(ip);
         }
 
-        if (devInfo && devInfo->isValid() && devInfo->discoveryMode() == DeviceInfo::DiscoveryMode::Everyone)
-            devInfoList << devInfo;
+        QMutexLocker lk(&parsedLock);
+        if (parsedPeers.size() >= kMaxParsedPeers)
+            parsedPeers.clear();
+        parsedPeers.insert(ip, { app.json, info });
+        return info ? DeviceInfoPointer(new DeviceInfo(*info)) : nullptr;
     }
 
-    return devInfoList;
+    return nullptr;
 }
 
 CooperationUtil::CooperationUtil(QObject *parent)
@@ -417,7 +436,7 @@ void CooperationUtil::asyncDiscoveryDevice()
 {
     if (!d->backendOk) {
         LOG << "The ping backend is false";
-        Q_EMIT discoveryFinished({});
+        Q_EMIT discoveryFinished({}, -1);
         return;
     }
 
@@ -430,6 +449,7 @@ void CooperationUtil::asyncDiscoveryDevice()
         rpcClient.close();
 
         QList<DeviceInfoPointer> infoList;
+        int version = -1;
         bool ok = res.get("result").as_bool();
         if (!ok) {
             WLOG << "discovery devices failed!";
@@ -437,10 +457,13 @@ void CooperationUtil::asyncDiscoveryDevice()
             DLOG << "all device: " << res.get("msg").as_string();
             co::Json obj;
             obj.parse_from(res.get("msg").as_string());
-            infoList = d->parseDeviceInfo(obj);
+            NodeList nodeList;
+            nodeList.from_json(obj);
+            version = nodeList.version;
+            infoList = d->parseDeviceInfo(nodeList);
         }
 
-        Q_EMIT discoveryFinished(infoList);
+        Q_EMIT discoveryFinished(infoList, version);
     });
 }
 
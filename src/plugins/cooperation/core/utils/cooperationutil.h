@@ -37,7 +37,8 @@ public:
     void showFeatureDisplayDialog(QDialog *dlg);
 
 Q_SIGNALS:
-    void discoveryFinished(const QList<DeviceInfoPointer> &infoList);
+    // version is the daemon discovery version of the list, -1 on failure
+    void discoveryFinished(const QList<DeviceInfoPointer> &infoList, int version);
 
 private:
     explicit CooperationUtil(QObject *parent = nullptr);
@@ -12,8 +12,12 @@
 #include <co/co.h>
 
 #include <QObject>
+#include <QHash>
+#include <QMutex>
 
 class FrontendService;
+struct NodeInfo;
+struct NodeList;
 namespace cooperation_core {
 
 class MainWindow;
@@ -27,7 +31,8 @@ public:
 
     bool pingBackend();
     void localIPCStart();
-    QList<DeviceInfoPointer> parseDeviceInfo(const co::Json &obj);
+    QList<DeviceInfoPointer> parseDeviceInfo(NodeList &nodeList);
+    DeviceInfoPointer parseNodeInfo(const NodeInfo &node);
 
 public:
     CooperationUtil *q { nullptr };
@@ -37,6 +42,15 @@ public:
     QString sessionId;
     bool backendOk { false };
     bool thisDestruct { false };
+
+    // 设备信息很少变化，json 未变时复用上次解析的结果
+    struct ParsedPeer
+    {
+        fastring json;
+        DeviceInfoPointer info;
+    };
+    QMutex parsedLock;
+    QHash<QString, ParsedPeer> parsedPeers;
 };
 
 }
@@ -6,13 +6,165 @@
 #include "historymanager.h"
 
 #include "configs/settings/configmanager.h"
+#include "configs/settings/settings.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
 
 using namespace cooperation_core;
 
+// Records kept per history, older ones are dropped
+static constexpr int kMaxHistoryCount = 100;
+// Writes within this interval are saved together
+static constexpr int kSaveDelay = 1000;
+
+QString HistoryManager::Cache::value(const QString &ip) const
+{
+    return records.value(ip).value;
+}
+
+bool HistoryManager::Cache::insert(const QString &ip, const QString &value, QString *evicted)
+{
+    auto iter = records.find(ip);
+    if (iter != records.end()) {
+        order.splice(order.begin(), order, iter->pos);
+        // The new seq has to be saved too, or the order is lost on reload
+        iter->seq = ++lastSeq;
+        changed.insert(ip);
+        if (iter->value == value)
+            return false;
+
+        iter->value = value;
+        return true;
+    }
+
+    order.push_front(ip);
+    records.insert(ip, { value, ++lastSeq, order.begin() });
+    changed.insert(ip);
+    if (static_cast<int>(order.size()) > kMaxHistoryCount) {
+        if (evicted)
+            *evicted = order.back();
+        changed.insert(order.back());
+        records.remove(order.back());
+        order.pop_back();
+    }
+
+    return true;
+}
+
+bool HistoryManager::Cache::apply(const QString &ip, const QString &value, qint64 seq, QString *evicted)
+{
+    auto iter = records.find(ip);
+    if (iter != records.end()) {
+        if (iter->value == value && iter->seq == seq)
+            return false;
+
+        order.erase(iter->pos);
+        records.erase(iter);
+    }
+
+    // Keep the list ordered by seq, the other writer may be behind us
+    auto pos = order.begin();
+    while (pos != order.end() && records.value(*pos).seq > seq)
+        ++pos;
+    pos = order.insert(pos, ip);
+    records.insert(ip, { value, seq, pos });
+    lastSeq = std::max(lastSeq, seq);
+
+    if (static_cast<int>(order.size()) > kMaxHistoryCount) {
+        if (evicted)
+            *evicted = order.back();
+        changed.insert(order.back());
+        records.remove(order.back());
+        order.pop_back();
+    }
+
+    return records.contains(ip);
+}
+
+bool HistoryManager::Cache::drop(const QString &ip)
+{
+    auto iter = records.find(ip);
+    if (iter == records.end())
+        return false;
+
+    order.erase(iter->pos);
+    records.erase(iter);
+    return true;
+}
+
+bool HistoryManager::Cache::remove(const QString &ip)
+{
+    auto iter = records.find(ip);
+    if (iter == records.end())
+        return false;
+
+    order.erase(iter->pos);
+    records.erase(iter);
+    changed.insert(ip);
+    return true;
+}
+
+void HistoryManager::Cache::load(Settings *setting, const QString &group, const QString &valueKey)
+{
+    QList<QPair<qint64, QString>> saved;
+    for (const auto &ip : setting->keys(group))
+        saved.append({ setting->value(group, ip).toMap().value("seq").toLongLong(), ip });
+
+    // Oldest first, so the newest record ends up in front. The saved seqs
+    // are kept, new records continue after the largest one.
+    std::sort(saved.begin(), saved.end());
+    for (const auto &item : saved) {
+        const auto &value = setting->value(group, item.second).toMap().value(valueKey).toString();
+        if (item.second.isEmpty() || value.isEmpty())
+            continue;
+
+        order.push_front(item.second);
+        records.insert(item.second, { value, item.first, order.begin() });
+        lastSeq = std::max(lastSeq, item.first);
+    }
+
+    // Records over the limit are dropped from the file as well
+    while (static_cast<int>(order.size()) > kMaxHistoryCount) {
+        changed.insert(order.back());
+        records.remove(order.back());
+        order.pop_back();
+    }
+}
+
+void HistoryManager::Cache::save(Settings *setting, const QString &group, const QString &valueKey)
+{
+    for (const auto &ip : changed) {
+        auto iter = records.constFind(ip);
+        if (iter == records.constEnd()) {
+            setting->remove(group, ip);
+            continue;
+        }
+
+        setting->setValueNoNotify(group, ip, QVariantMap { { valueKey, iter->value }, { "seq", iter->seq } });
+    }
+    changed.clear();
+}
+
 HistoryManager::HistoryManager(QObject *parent)
     : QObject(parent)
 {
+    saveTimer.setSingleShot(true);
+    saveTimer.setInterval(kSaveDelay);
+    connect(&saveTimer, &QTimer::timeout, this, &HistoryManager::save);
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &HistoryManager::save);
+
+    load();
+
+    // 旧版本守护进程仍可能写入应用配置中的历史记录
     connect(ConfigManager::instance(), &ConfigManager::appAttributeChanged, this, &HistoryManager::onAttributeChanged);
+    connect(historySetting, &Settings::valueChanged, this, &HistoryManager::onHistoryChanged);
+}
+
+HistoryManager::~HistoryManager()
+{
+    save();
 }
 
 HistoryManager *HistoryManager::instance()
@@ -21,116 +173,209 @@ HistoryManager *HistoryManager::instance()
     return &ins;
 }
 
-void HistoryManager::onAttributeChanged(const QString &group, const QString &key, const QVariant &value)
+void HistoryManager::load()
 {
-    Q_UNUSED(value)
+    const auto &orgName = qApp->organizationName();
 
-    if (group != AppSettings::CacheGroup)
-        return;
+    // 历史记录单独保存，不随应用配置一起写入；与应用配置一样以主程序命名，
+    // 文件传输程序和守护进程共用这一份
+    historySetting = new Settings(QString("%1/%2/history").arg(orgName, MainAppName), Settings::GenericConfig, this);
+    historySetting->setJournalGroups({ AppSettings::TransHistoryKey, AppSettings::ConnectHistoryKey });
+    historySetting->setWatchChanges(true);
 
-    if (key == AppSettings::TransHistoryKey) {
-        Q_EMIT transHistoryUpdated();
+    transCache.load(historySetting, AppSettings::TransHistoryKey, "savePath");
+    connectCache.load(historySetting, AppSettings::ConnectHistoryKey, "devName");
+
+    migrate(AppSettings::TransHistoryKey);
+    migrate(AppSettings::ConnectHistoryKey);
+    save();
+}
+
+void HistoryManager::migrate(const QString &key)
+{
+    // 旧版本的历史记录以列表形式保存在应用配置中，合并进来后删除
+    const auto &old = ConfigManager::instance()->appAttribute(AppSettings::CacheGroup, key);
+    if (!old.isValid())
         return;
+
+    const bool trans = key == AppSettings::TransHistoryKey;
+    const QString valueKey = trans ? "savePath" : "devName";
+    Cache &cache = trans ? transCache : connectCache;
+    QList<QPair<QString, QString>> updated;
+    QStringList evictedIps;
+    {
+        QWriteLocker lk(&lock);
+        for (const auto &item : old.toList()) {
+            const auto &map = item.toMap();
+            const auto &ip = map.value("ip").toString();
+            const auto &value = map.value(valueKey).toString();
+            // The legacy writer only rewrites the list, a differing value is newer
+            if (ip.isEmpty() || value.isEmpty() || cache.value(ip) == value)
+                continue;
+
+            QString evicted;
+            cache.insert(ip, value, &evicted);
+            updated.append({ ip, value });
+            if (!evicted.isEmpty())
+                evictedIps.append(evicted);
+        }
     }
 
-    if (key == AppSettings::ConnectHistoryKey)
-        Q_EMIT connectHistoryUpdated();
+    ConfigManager::instance()->appSetting()->remove(AppSettings::CacheGroup, key);
+    if (updated.isEmpty())
+        return;
+
+    scheduleSave();
+    for (const auto &ip : evictedIps)
+        notifyChanged(trans, ip, QString());
+    for (const auto &item : updated)
+        notifyChanged(trans, item.first, item.second);
 }
 
-QMap<QString, QString> HistoryManager::getTransHistory()
+void HistoryManager::notifyChanged(bool trans, const QString &ip, const QString &value)
 {
-    QMap<QString, QString> dataMap;
+    if (trans)
+        Q_EMIT transHistoryChanged(ip, value);
+    else
+        Q_EMIT connectHistoryChanged(ip, value);
+}
 
-    const auto &list = ConfigManager::instance()->appAttribute(AppSettings::CacheGroup, AppSettings::TransHistoryKey).toList();
-    for (const auto &item : list) {
-        const auto &map = item.toMap();
-        const auto &ip = map.value("ip").toString();
-        const auto &path = map.value("savePath").toString();
-        if (ip.isEmpty() || path.isEmpty())
-            continue;
+void HistoryManager::onAttributeChanged(const QString &group, const QString &key, const QVariant &value)
+{
+    if (group != AppSettings::CacheGroup || !value.isValid())
+        return;
+
+    if (key == AppSettings::TransHistoryKey || key == AppSettings::ConnectHistoryKey)
+        migrate(key);
+}
+
+void HistoryManager::onHistoryChanged(const QString &group, const QString &key, const QVariant &value)
+{
+    // Written by another process, or our own removal coming back
+    const bool trans = group == AppSettings::TransHistoryKey;
+    if (!trans && group != AppSettings::ConnectHistoryKey)
+        return;
 
-        dataMap.insert(ip, path);
+    const auto &map = value.toMap();
+    const QString &newValue = map.value(trans ? "savePath" : "devName").toString();
+    QString evicted;
+    bool changed = false;
+    {
+        QWriteLocker lk(&lock);
+        Cache &cache = trans ? transCache : connectCache;
+        changed = newValue.isEmpty() ? cache.drop(key) : cache.apply(key, newValue, map.value("seq").toLongLong(), &evicted);
     }
 
-    return dataMap;
+    if (!evicted.isEmpty()) {
+        scheduleSave();
+        notifyChanged(trans, evicted, QString());
+    }
+    if (changed)
+        notifyChanged(trans, key, newValue);
 }
 
-void HistoryManager::writeIntoTransHistory(const QString &ip, const QString &savePath)
+void HistoryManager::scheduleSave()
 {
-    auto history = getTransHistory();
-    if (history.contains(ip) && history.value(ip) == savePath)
-        return;
+    if (!saveTimer.isActive())
+        saveTimer.start();
+}
+
+void HistoryManager::save()
+{
+    saveTimer.stop();
 
-    history.insert(ip, savePath);
-    QVariantList list;
-    auto iter = history.begin();
-    while (iter != history.end()) {
-        QVariantMap map;
-        map.insert("ip", iter.key());
-        map.insert("savePath", iter.value());
+    {
+        QWriteLocker lk(&lock);
+        if (transCache.changed.isEmpty() && connectCache.changed.isEmpty())
+            return;
 
-        list << map;
-        ++iter;
+        transCache.save(historySetting, AppSettings::TransHistoryKey, "savePath");
+        connectCache.save(historySetting, AppSettings::ConnectHistoryKey, "devName");
     }
 
-    ConfigManager::instance()->setAppAttribute(AppSettings::CacheGroup, AppSettings::TransHistoryKey, list);
+    // Only the changed records are appended to the journal
+    historySetting->sync();
 }
 
-void HistoryManager::removeTransHistory(const QString &ip)
+QString HistoryManager::transHistoryPath(const QString &ip) const
+{
+    QReadLocker lk(&lock);
+    return transCache.value(ip);
+}
+
+bool HistoryManager::hasTransHistory(const QString &ip) const
 {
-    auto history = getTransHistory();
-    if (history.remove(ip) == 0)
+    QReadLocker lk(&lock);
+    return transCache.records.contains(ip);
+}
+
+void HistoryManager::writeIntoTransHistory(const QString &ip, const QString &savePath)
+{
+    if (ip.isEmpty() || savePath.isEmpty())
         return;
 
-    QVariantList list;
-    auto iter = history.begin();
-    while (iter != history.end()) {
-        QVariantMap map;
-        map.insert("ip", iter.key());
-        map.insert("savePath", iter.value());
+    QString evicted;
+    bool updated = false;
+    {
+        QWriteLocker lk(&lock);
+        updated = transCache.insert(ip, savePath, &evicted);
+    }
 
-        list << map;
-        ++iter;
+    // The record moved to the front even if its value is the same
+    scheduleSave();
+    if (!updated)
+        return;
+    if (!evicted.isEmpty())
+        Q_EMIT transHistoryChanged(evicted, QString());
+    Q_EMIT transHistoryChanged(ip, savePath);
+}
+
+void HistoryManager::removeTransHistory(const QString &ip)
+{
+    {
+        QWriteLocker lk(&lock);
+        if (!transCache.remove(ip))
+            return;
     }
 
-    ConfigManager::instance()->setAppAttribute(AppSettings::CacheGroup, AppSettings::TransHistoryKey, list);
+    scheduleSave();
+    Q_EMIT transHistoryChanged(ip, QString());
 }
 
-QMap<QString, QString> HistoryManager::getConnectHistory()
+QMap<QString, QString> HistoryManager::getConnectHistory() const
 {
     QMap<QString, QString> dataMap;
 
-    const auto &list = ConfigManager::instance()->appAttribute(AppSettings::CacheGroup, AppSettings::ConnectHistoryKey).toList();
-    for (const auto &item : list) {
-        const auto &map = item.toMap();
-        const auto &ip = map.value("ip").toString();
-        const auto &devName = map.value("devName").toString();
-        if (ip.isEmpty() || devName.isEmpty())
-            continue;
-
-        dataMap.insert(ip, devName);
-    }
+    QReadLocker lk(&lock);
+    for (auto iter = connectCache.records.cbegin(); iter != connectCache.records.cend(); ++iter)
+        dataMap.insert(iter.key(), iter->value);
 
     return dataMap;
 }
 
+QString HistoryManager::connectHistoryName(const QString &ip) const
+{
+    QReadLocker lk(&lock);
+    return connectCache.value(ip);
+}
+
 void HistoryManager::writeIntoConnectHistory(const QString &ip, const QString &devName)
 {
-    auto history = getConnectHistory();
-    if (history.contains(ip) && history.value(ip) == devName)
+    if (ip.isEmpty() || devName.isEmpty())
         return;
 
-    history.insert(ip, devName);
-    QVariantList list;
-    auto iter = history.begin();
-    while (iter != history.end()) {
-        QVariantMap map;
-        map.insert("ip", iter.key());
-        map.insert("devName", iter.value());
-
-        list << map;
-        ++iter;
+    QString evicted;
+    bool updated = false;
+    {
+        QWriteLocker lk(&lock);
+        updated = connectCache.insert(ip, devName, &evicted);
     }
 
-    ConfigManager::instance()->setAppAttribute(AppSettings::CacheGroup, AppSettings::ConnectHistoryKey, list);
+    // The record moved to the front even if its value is the same
+    scheduleSave();
+    if (!updated)
+        return;
+    if (!evicted.isEmpty())
+        Q_EMIT connectHistoryChanged(evicted, QString());
+    Q_EMIT connectHistoryChanged(ip, devName);
 }
@@ -7,28 +7,89 @@
 
 #include "global_defines.h"
 
+#include <QHash>
+#include <QSet>
+#include <QReadWriteLock>
+#include <QTimer>
+
+#include <list>
+
+class Settings;
 namespace cooperation_core {
 
+// Lookups are thread safe, writes happen on the GUI thread
 class HistoryManager : public QObject
 {
     Q_OBJECT
 public:
     static HistoryManager *instance();
 
-    QMap<QString, QString> getTransHistory();
+    QString transHistoryPath(const QString &ip) const;
+    bool hasTransHistory(const QString &ip) const;
     void writeIntoTransHistory(const QString &ip, const QString &savePath);
     void removeTransHistory(const QString &ip);
 
-    QMap<QString, QString> getConnectHistory();
+    QMap<QString, QString> getConnectHistory() const;
+    QString connectHistoryName(const QString &ip) const;
     void writeIntoConnectHistory(const QString &ip, const QString &devName);
 
+public Q_SLOTS:
+    void save();
+
 Q_SIGNALS:
-    void transHistoryUpdated();
-    void connectHistoryUpdated();
+    // value is empty when the record was removed
+    void transHistoryChanged(const QString &ip, const QString &savePath);
+    void connectHistoryChanged(const QString &ip, const QString &devName);
 
 private:
+    // Bounded ip -> value map, the least recently written record is dropped first
+    struct Cache
+    {
+        QString value(const QString &ip) const;
+        // Returns false if the record was already there with this value
+        bool insert(const QString &ip, const QString &value, QString *evicted);
+        bool remove(const QString &ip);
+        // A record saved by another process, it is already on disk
+        bool apply(const QString &ip, const QString &value, qint64 seq, QString *evicted);
+        bool drop(const QString &ip);
+
+        // Each record is saved as its own key, so a save only writes what changed
+        void load(Settings *setting, const QString &group, const QString &valueKey);
+        void save(Settings *setting, const QString &group, const QString &valueKey);
+
+        struct Record
+        {
+            QString value;
+            // Larger is more recent, saved to restore the order
+            qint64 seq;
+            std::list<QString>::iterator pos;
+        };
+
+        // most recently written first
+        std::list<QString> order;
+        QHash<QString, Record> records;
+        qint64 lastSeq { 0 };
+        // ips written or dropped since the last save
+        QSet<QString> changed;
+    };
+
     explicit HistoryManager(QObject *parent = nullptr);
+    ~HistoryManager();
+
+    void load();
+    void migrate(const QString &key);
     void onAttributeChanged(const QString &group, const QString &key, const QVariant &value);
+    void onHistoryChanged(const QString &group, const QString &key, const QVariant &value);
+    void notifyChanged(bool trans, const QString &ip, const QString &value);
+    void scheduleSave();
+
+private:
+    mutable QReadWriteLock lock;
+    Cache transCache;
+    Cache connectCache;
+
+    Settings *historySetting { nullptr };
+    QTimer saveTimer;
 };
 
 }   // namespace cooperation_core
@@ -5,16 +5,21 @@
 #include "sortfilterworker.h"
 #include "utils/historymanager.h"
 
-using TransHistoryInfo = QMap<QString, QString>;
-Q_GLOBAL_STATIC(TransHistoryInfo, transHistory)
+#include <QTimer>
+
+#include <algorithm>
 
 using namespace cooperation_core;
 
+static QString searchKeyOf(const DeviceInfoPointer &info)
+{
+    return (info->deviceName() + '\n' + info->ipAddress()).toCaseFolded();
+}
+
 SortFilterWorker::SortFilterWorker(QObject *parent)
     : QObject(parent)
 {
-    onTransHistoryUpdated();
-    connect(HistoryManager::instance(), &HistoryManager::transHistoryUpdated, this, &SortFilterWorker::onTransHistoryUpdated, Qt::QueuedConnection);
+    connect(HistoryManager::instance(), &HistoryManager::transHistoryChanged, this, &SortFilterWorker::onTransHistoryChanged, Qt::QueuedConnection);
 }
 
 void SortFilterWorker::stop()
@@ -22,37 +27,79 @@ void SortFilterWorker::stop()
     isStoped = true;
 }
 
-void SortFilterWorker::onTransHistoryUpdated()
+void SortFilterWorker::onTransHistoryChanged(const QString &ip)
 {
-    *transHistory = HistoryManager::instance()->getTransHistory();
+    auto iter = entries.find(ip);
+    if (iter == entries.end())
+        return;
+
+    Entry &entry = iter.value();
+    const int bucket = bucketOf(entry.info);
+    if (bucket == entry.bucket)
+        return;
+
+    const int from = entry.visible ? visibleRow(entry) : -1;
+    unplace(entry);
+    seqIps.remove(entry.seq);
+    entry.bucket = bucket;
+    place(entry, true);
+    if (entry.visible)
+        pushChange(DeviceChange::Moved, from, visibleRow(entry), entry.info);
 }
 
-int SortFilterWorker::calculateIndex(const QList<DeviceInfoPointer> &list, const DeviceInfoPointer info)
+int SortFilterWorker::bucketOf(const DeviceInfoPointer &info) const
 {
-    int index = 0;
     switch (info->connectStatus()) {
     case DeviceInfo::Connected:
-        // 连接中的设备放第一个
-        index = 0;
-        break;
-    case DeviceInfo::Connectable: {
-        index = findLast(list, DeviceInfo::Connectable, info);
-        if (index != -1)
-            break;
-
-        index = findFirst(list, DeviceInfo::Offline);
-        if (index != -1)
-            break;
-
-        index = list.size();
-    } break;
+        return kConnected;
+    case DeviceInfo::Connectable:
+        return HistoryManager::instance()->hasTransHistory(info->ipAddress()) ? kRecorded : kConnectable;
     case DeviceInfo::Offline:
     default:
-        index = list.size();
-        break;
+        return kOffline;
     }
+}
 
-    return index;
+bool SortFilterWorker::matches(const Entry &entry) const
+{
+    return filterKey.isEmpty() || entry.searchKey.contains(filterKey);
+}
+
+int SortFilterWorker::visibleRow(const Entry &entry) const
+{
+    int row = 0;
+    for (int i = 0; i < entry.bucket; ++i)
+        row += orders[i].visible.size();
+
+    const QVector<qint64> &visible = orders[entry.bucket].visible;
+    return row + static_cast<int>(std::lower_bound(visible.cbegin(), visible.cend(), entry.seq) - visible.cbegin());
+}
+
+void SortFilterWorker::place(Entry &entry, bool newSeq)
+{
+    if (newSeq) {
+        // 连接中的设备放第一个，其余按加入顺序排列
+        ++lastSeq;
+        entry.seq = entry.bucket == kConnected ? -lastSeq : lastSeq;
+        seqIps.insert(entry.seq, entry.info->ipAddress());
+    }
+
+    QVector<qint64> &all = orders[entry.bucket].all;
+    all.insert(std::lower_bound(all.begin(), all.end(), entry.seq), entry.seq);
+    if (entry.visible) {
+        QVector<qint64> &visible = orders[entry.bucket].visible;
+        visible.insert(std::lower_bound(visible.begin(), visible.end(), entry.seq), entry.seq);
+    }
+}
+
+void SortFilterWorker::unplace(const Entry &entry)
+{
+    QVector<qint64> &all = orders[entry.bucket].all;
+    all.erase(std::lower_bound(all.begin(), all.end(), entry.seq));
+    if (entry.visible) {
+        QVector<qint64> &visible = orders[entry.bucket].visible;
+        visible.erase(std::lower_bound(visible.begin(), visible.end(), entry.seq));
+    }
 }
 
 void SortFilterWorker::addDevice(const QList<DeviceInfoPointer> &infoList)
@@ -64,158 +111,148 @@ void SortFilterWorker::addDevice(const QList<DeviceInfoPointer> &infoList)
         if (isStoped)
             return;
 
-        // 分别进行更新
-        if (contains(allDeviceList, info)) {
-            updateDevice(allDeviceList, info, false);
-            if (contains(visibleDeviceList, info))
-                updateDevice(visibleDeviceList, info, true);
+        auto iter = entries.find(info->ipAddress());
+        if (iter != entries.end()) {
+            updateEntry(iter.value(), info);
             continue;
         }
 
         if (info->connectStatus() == DeviceInfo::Unknown)
             info->setConnectStatus(DeviceInfo::Connectable);
 
-        auto index = calculateIndex(allDeviceList, info);
-        allDeviceList.insert(index, info);
+        Entry entry { info, searchKeyOf(info), bucketOf(info), 0, false };
+        entry.visible = matches(entry);
+        place(entry, true);
+        if (entry.visible)
+            pushChange(DeviceChange::Inserted, -1, visibleRow(entry), info);
+        entries.insert(info->ipAddress(), entry);
+    }
+
+    finishPending = true;
+    scheduleFlush();
+}
 
-        // 判断是否需要过滤
-        if (!filterText.isEmpty()) {
-            if (info->deviceName().contains(filterText, Qt::CaseInsensitive)
-                || info->ipAddress().contains(filterText, Qt::CaseInsensitive))
-                index = calculateIndex(visibleDeviceList, info);
-            else
-                continue;
-        }
+void SortFilterWorker::updateEntry(Entry &entry, const DeviceInfoPointer info)
+{
+    if (info->connectStatus() == DeviceInfo::Unknown) {
+        // 设备属性发生改变时，连接状态为Unknown
+        // 若设备为非离线状态，则保持状态不变
+        auto status = entry.info->connectStatus();
+        info->setConnectStatus(status == DeviceInfo::Offline ? DeviceInfo::Connectable : status);
+    }
 
-        visibleDeviceList.insert(index, info);
-        Q_EMIT sortFilterResult(index, info);
+    // 当连接状态不一致时，需要更新位置
+    const bool needMove = entry.info->connectStatus() != info->connectStatus();
+    const bool wasVisible = entry.visible;
+    const int from = wasVisible ? visibleRow(entry) : -1;
+
+    entry.info = info;
+    entry.searchKey = searchKeyOf(info);
+    const bool visible = matches(entry);
+    if (!needMove && visible == wasVisible) {
+        if (visible)
+            pushChange(DeviceChange::Updated, from, from, info);
+        return;
     }
 
-    Q_EMIT filterFinished();
+    unplace(entry);
+    if (needMove) {
+        seqIps.remove(entry.seq);
+        entry.bucket = bucketOf(info);
+    }
+    entry.visible = visible;
+    place(entry, needMove);
+
+    if (wasVisible && visible)
+        pushChange(DeviceChange::Moved, from, visibleRow(entry), info);
+    else if (wasVisible)
+        pushChange(DeviceChange::Removed, from, -1, info);
+    else
+        pushChange(DeviceChange::Inserted, -1, visibleRow(entry), info);
 }
 
 void SortFilterWorker::removeDevice(const QString &ip)
 {
-    for (int i = 0; i < visibleDeviceList.size(); ++i) {
-        if (visibleDeviceList[i]->ipAddress() != ip)
-            continue;
+    auto iter = entries.find(ip);
+    if (iter == entries.end())
+        return;
 
-        allDeviceList.removeOne(visibleDeviceList[i]);
-        visibleDeviceList.removeAt(i);
-        Q_EMIT deviceRemoved(i);
-        break;
-    }
+    const Entry entry = iter.value();
+    entries.erase(iter);
+    const int row = entry.visible ? visibleRow(entry) : -1;
+    unplace(entry);
+    seqIps.remove(entry.seq);
+    if (entry.visible)
+        pushChange(DeviceChange::Removed, row, -1, entry.info);
 }
 
 void SortFilterWorker::filterDevice(const QString &filter)
 {
-    filterText = filter;
-    visibleDeviceList.clear();
-    int index = -1;
-    for (const auto &dev : allDeviceList) {
-        if (dev->deviceName().contains(filter, Qt::CaseInsensitive)
-            || dev->ipAddress().contains(filter, Qt::CaseInsensitive)) {
-            ++index;
-            visibleDeviceList.append(dev);
-            Q_EMIT sortFilterResult(index, dev);
+    const QString key = filter.toCaseFolded();
+    // A longer filter can only hide devices, so only the visible ones are checked
+    const bool narrowing = key.contains(filterKey);
+    filterKey = key;
+
+    int row = 0;
+    for (Order &order : orders) {
+        const QVector<qint64> candidates = narrowing ? order.visible : order.all;
+        QVector<qint64> visible;
+        visible.reserve(candidates.size());
+        for (qint64 seq : candidates) {
+            Entry &entry = entries[seqIps.value(seq)];
+            const bool match = matches(entry);
+            if (entry.visible && !match)
+                pushChange(DeviceChange::Removed, row, -1, entry.info);
+            else if (!entry.visible && match)
+                pushChange(DeviceChange::Inserted, -1, row, entry.info);
+            entry.visible = match;
+            if (match) {
+                visible.append(seq);
+                ++row;
+            }
         }
+        order.visible = visible;
     }
 
-    Q_EMIT filterFinished();
+    finishPending = true;
+    scheduleFlush();
 }
 
 void SortFilterWorker::clear()
 {
-    allDeviceList.clear();
-    visibleDeviceList.clear();
+    entries.clear();
+    seqIps.clear();
+    for (Order &order : orders) {
+        order.all.clear();
+        order.visible.clear();
+    }
+    pendingChanges.clear();
 }
 
-int SortFilterWorker::findFirst(const QList<DeviceInfoPointer> &list, DeviceInfo::ConnectStatus state)
+void SortFilterWorker::pushChange(DeviceChange::Type type, int from, int to, const DeviceInfoPointer &info)
 {
-    int index = -1;
-    auto iter = std::find_if(list.cbegin(), list.cend(),
-                             [&](const DeviceInfoPointer info) {
-                                 if (isStoped)
-                                     return true;
-                                 index++;
-                                 return info->connectStatus() == state;
-                             });
-
-    if (iter == list.cend())
-        return -1;
-
-    return index;
+    pendingChanges.append({ type, from, to, info });
+    scheduleFlush();
 }
 
-int SortFilterWorker::findLast(const QList<DeviceInfoPointer> &list, DeviceInfo::ConnectStatus state, const DeviceInfoPointer info)
+void SortFilterWorker::scheduleFlush()
 {
-    bool isRecord = transHistory->contains(info->ipAddress());
-    int startPos = -1;
-    int endPos = -1;
-
-    for (int i = list.size() - 1; i >= 0; --i) {
-        if (list[i]->connectStatus() == state) {
-            startPos = (startPos == -1 ? i : startPos);
-            endPos = i;
-
-            if (!isRecord)
-                return startPos + 1;
-
-            if (transHistory->contains(list[i]->ipAddress()))
-                return endPos + 1;
-        }
-    }
-
-    return qMin(startPos, endPos);
+    if (flushScheduled)
+        return;
+    flushScheduled = true;
+    QTimer::singleShot(0, this, &SortFilterWorker::flush);
 }
 
-void SortFilterWorker::updateDevice(QList<DeviceInfoPointer> &list, const DeviceInfoPointer info, bool needNotify)
+void SortFilterWorker::flush()
 {
-    // 更新
-    int index = indexOf(list, info);
-    if (info->connectStatus() == DeviceInfo::Unknown) {
-        // 设备属性发生改变时，连接状态为Unknown
-        // 若设备为非离线状态，则保持状态不变
-        auto status = list[index]->connectStatus();
-        info->setConnectStatus(status == DeviceInfo::Offline ? DeviceInfo::Connectable : status);
+    flushScheduled = false;
+    if (!pendingChanges.isEmpty()) {
+        Q_EMIT devicesChanged(pendingChanges);
+        pendingChanges.clear();
     }
 
-    // 当连接状态不一致时，需要更新位置
-    bool needMove = list[index]->connectStatus() != info->connectStatus();
-    if (needMove) {
-        list.removeAt(index);
-        auto to = calculateIndex(list, info);
-        list.insert(to, info);
-        if (needNotify)
-            Q_EMIT deviceMoved(index, to, info);
-    } else {
-        list.replace(index, info);
-        if (needNotify)
-            Q_EMIT deviceUpdated(index, info);
+    if (finishPending) {
+        finishPending = false;
+        Q_EMIT filterFinished();
     }
 }
-
-bool SortFilterWorker::contains(const QList<DeviceInfoPointer> &list, const DeviceInfoPointer info)
-{
-    auto iter = std::find_if(list.begin(), list.end(),
-                             [&info](const DeviceInfoPointer it) {
-                                 return it->ipAddress() == info->ipAddress();
-                             });
-
-    return iter != list.end();
-}
-
-int SortFilterWorker::indexOf(const QList<DeviceInfoPointer> &list, const DeviceInfoPointer info)
-{
-    int index = -1;
-    auto iter = std::find_if(list.begin(), list.end(),
-                             [&](const DeviceInfoPointer it) {
-                                 index++;
-                                 return it->ipAddress() == info->ipAddress();
-                             });
-
-    if (iter == list.end())
-        return -1;
-
-    return index;
-}
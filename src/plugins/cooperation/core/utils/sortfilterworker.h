@@ -8,10 +8,29 @@
 #include "global_defines.h"
 #include "info/deviceinfo.h"
 
+#include <QHash>
 #include <QObject>
+#include <QVector>
 
 namespace cooperation_core {
 
+// One step of a diff against the visible device list, rows are those of the
+// list after every earlier change of the same batch has been applied
+struct DeviceChange
+{
+    enum Type {
+        Inserted,
+        Removed,
+        Updated,
+        Moved
+    };
+
+    Type type;
+    int from;
+    int to;
+    DeviceInfoPointer info;
+};
+
 class SortFilterWorker : public QObject
 {
     Q_OBJECT
@@ -27,30 +46,69 @@ public Q_SLOTS:
     void clear();
 
 Q_SIGNALS:
-    void sortFilterResult(int index, const DeviceInfoPointer info);
-    void deviceRemoved(int index);
-    void deviceUpdated(int index, const DeviceInfoPointer info);
-    void deviceMoved(int from, int to, const DeviceInfoPointer info);
+    // Changes made within one event loop pass are sent together
+    void devicesChanged(const QList<DeviceChange> &changes);
     void filterFinished();
 
 private Q_SLOTS:
-    void onTransHistoryUpdated();
+    void onTransHistoryChanged(const QString &ip);
+    void flush();
 
 private:
-    int calculateIndex(const QList<DeviceInfoPointer> &list, const DeviceInfoPointer info);
-    int findFirst(const QList<DeviceInfoPointer> &list, DeviceInfo::ConnectStatus state);
-    int findLast(const QList<DeviceInfoPointer> &list, DeviceInfo::ConnectStatus state, const DeviceInfoPointer info);
-    void updateDevice(QList<DeviceInfoPointer> &list, const DeviceInfoPointer info, bool needNotify);
-    bool contains(const QList<DeviceInfoPointer> &list, const DeviceInfoPointer info);
-    int indexOf(const QList<DeviceInfoPointer> &list, const DeviceInfoPointer info);
+    // Display order: connected devices (newest first), connectable devices
+    // with transfer history, other connectable devices, offline devices
+    enum Bucket {
+        kConnected,
+        kRecorded,
+        kConnectable,
+        kOffline,
+        kBucketCount
+    };
+
+    struct Entry
+    {
+        DeviceInfoPointer info;
+        // Case folded "name\nip", matched against the filter
+        QString searchKey;
+        int bucket;
+        // Position inside the bucket
+        qint64 seq;
+        bool visible;
+    };
+
+    struct Order
+    {
+        // Sorted sequence numbers of all devices and of the visible ones
+        QVector<qint64> all;
+        QVector<qint64> visible;
+    };
+
+    int bucketOf(const DeviceInfoPointer &info) const;
+    bool matches(const Entry &entry) const;
+    int visibleRow(const Entry &entry) const;
+    void place(Entry &entry, bool newSeq);
+    void unplace(const Entry &entry);
+    void updateEntry(Entry &entry, const DeviceInfoPointer info);
+    void pushChange(DeviceChange::Type type, int from, int to, const DeviceInfoPointer &info);
+    void scheduleFlush();
 
 private:
-    QList<DeviceInfoPointer> visibleDeviceList;
-    QList<DeviceInfoPointer> allDeviceList;
-    QString filterText;
+    // ip -> device
+    QHash<QString, Entry> entries;
+    QHash<qint64, QString> seqIps;
+    Order orders[kBucketCount];
+    qint64 lastSeq { 0 };
+
+    QString filterKey;
+
+    QList<DeviceChange> pendingChanges;
+    bool flushScheduled { false };
+    bool finishPending { false };
     std::atomic_bool isStoped { false };
 };
 
 }   // namespace cooperation_core
 
+Q_DECLARE_METATYPE(cooperation_core::DeviceChange)
+
 #endif   // SORTFILTERWORKER_H
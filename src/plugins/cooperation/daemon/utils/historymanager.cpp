@@ -5,14 +5,20 @@
 #include "global_defines.h"
 #include "historymanager.h"
 
-#include "configs/settings/configmanager.h"
+#include "configs/settings/settings.h"
 
+#include <QCoreApplication>
 #include <QVariantMap>
 
 using namespace daemon_cooperation;
 
 HistoryManager::HistoryManager()
 {
+    // 与界面进程共用主程序的历史记录文件
+    const auto &orgName = qApp->organizationName();
+    historySetting = new Settings(QString("%1/%2/history").arg(orgName, MainAppName), Settings::GenericConfig, qApp);
+    historySetting->setJournalGroups({ AppSettings::TransHistoryKey });
+    historySetting->setWatchChanges(true);
 }
 
 HistoryManager *HistoryManager::instance()
@@ -25,11 +31,8 @@ QMap<QString, QString> HistoryManager::getTransHistory()
 {
     QMap<QString, QString> dataMap;
 
-    const auto &list = ConfigManager::instance()->appAttribute(AppSettings::CacheGroup, AppSettings::TransHistoryKey).toList();
-    for (const auto &item : list) {
-        const auto &map = item.toMap();
-        const auto &ip = map.value("ip").toString();
-        const auto &path = map.value("savePath").toString();
+    for (const auto &ip : historySetting->keys(AppSettings::TransHistoryKey)) {
+        const auto &path = historySetting->value(AppSettings::TransHistoryKey, ip).toMap().value("savePath").toString();
         if (ip.isEmpty() || path.isEmpty())
             continue;
 
@@ -41,21 +44,14 @@ QMap<QString, QString> HistoryManager::getTransHistory()
 
 void HistoryManager::writeIntoTransHistory(const QString &ip, const QString &savePath)
 {
-    auto history = getTransHistory();
-    if (history.contains(ip) && history.value(ip) == savePath)
+    if (ip.isEmpty() || savePath.isEmpty())
         return;
 
-    history.insert(ip, savePath);
-    QVariantList list;
-    auto iter = history.begin();
-    while (iter != history.end()) {
-        QVariantMap map;
-        map.insert("ip", iter.key());
-        map.insert("savePath", iter.value());
+    // The newest record has the largest seq, the GUI orders and trims by it
+    qint64 seq = 0;
+    for (const auto &key : historySetting->keys(AppSettings::TransHistoryKey))
+        seq = qMax(seq, historySetting->value(AppSettings::TransHistoryKey, key).toMap().value("seq").toLongLong());
 
-        list << map;
-        ++iter;
-    }
-
-    ConfigManager::instance()->setAppAttribute(AppSettings::CacheGroup, AppSettings::TransHistoryKey, list);
+    historySetting->setValueNoNotify(AppSettings::TransHistoryKey, ip, QVariantMap { { "savePath", savePath }, { "seq", seq + 1 } });
+    historySetting->sync();
 }
@@ -9,8 +9,10 @@
 
 #include <QMap>
 
+class Settings;
 namespace daemon_cooperation {
 
+// Writes into the history store of the main application, the GUI watches it
 class HistoryManager
 {
 public:
@@ -21,6 +23,8 @@ public:
 
 private:
     explicit HistoryManager();
+
+    Settings *historySetting { nullptr };
 };
 
 }   // namespace daemon_cooperation
@@ -15,6 +15,8 @@
 #include <QMap>
 #include <QMutex>
 
+#include <memory>
+
 typedef enum chan_type_t {
     UNKOWN = 10,
     LOGIN_RESULT= 100,
@@ -44,12 +46,6 @@ typedef enum chan_type_t {
     DISCOVER_BY_TCP = 1023, // 通过ip搜索的设备，模拟udp包的发送
 } ChanType;
 
-struct IncomeData {
-    ChanType type;
-    fastring json; // json数据结构实例
-    fastring buf; // 二进制数据
-};
-
 typedef enum communication_type_t {
     COMM_APPLY_TRANS = 0, // 发送 发送文件请求和回复
 } CommunicationType;
@@ -59,8 +55,17 @@ struct OutData {
     fastring json; // json数据结构实例
 };
 
+// 每个请求独有的回复通道，并发的请求不会拿到彼此的回复
+typedef std::shared_ptr<co::chan<OutData>> ReplyChan;
+
+struct IncomeData {
+    ChanType type;
+    fastring json; // json数据结构实例
+    fastring buf; // 二进制数据
+    ReplyChan reply;
+};
+
 extern co::chan<IncomeData> _income_chan;
-extern co::chan<OutData> _outgo_chan;
 
 const static QList<uint16> clientPorts{
     7790, 7791
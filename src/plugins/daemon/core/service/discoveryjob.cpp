@@ -79,7 +79,7 @@ void DiscoveryJob::discovererRun()
                 } else { // 上线
                     //new node discovery.
                     //DLOG << "new peer found: " << node.str();
-                    emit sigNodeChanged(true, QString(service.info.c_str()));
+                    notifyNodeChanged(true, QString(service.info.c_str()));
                     _dis_node_maps.insert(uid, std::make_pair(service.info, true));
                 }
             }
@@ -94,7 +94,7 @@ void DiscoveryJob::discovererRun()
                 nodeInfo.from_json(node);
                 //DLOG << "peer losted: " << it->second.first;
                 nodeInfo.apps.clear();
-                emit sigNodeChanged(false, QString(nodeInfo.as_json().str().c_str()));
+                notifyNodeChanged(false, QString(nodeInfo.as_json().str().c_str()));
                 _dis_node_maps.erase(it);
             }
         }
@@ -195,10 +195,12 @@ fastring DiscoveryJob::baseInfo() const
     return ((searchlight::Announcer*)_announcer_p)->baseInfo();
 }
 
-co::list<fastring> DiscoveryJob::getNodes()
+co::list<fastring> DiscoveryJob::getNodes(int *version)
 {
     co::list<fastring> notes;
     QReadLocker lk(&_dis_lock);
+    if (version)
+        *version = _nodes_version;
     for (auto it = _dis_node_maps.begin(); it != _dis_node_maps.end(); ++it) {
         notes.push_back(it->second.first);
     }
@@ -243,7 +245,23 @@ void DiscoveryJob::searchDeviceByIp(const QString &ip, const bool remove)
         return;
     }
     ((searchlight::Discoverer*)_discoverer_p)->setSearchIp(ip);
-    emit sigNodeChanged(true, result.data.c_str());
+    {
+        // 记录到节点表，全量同步时才不会被当成离线
+        co::Json node;
+        node.parse_from(result.data);
+        co::Json osjson = node.get("os");
+        QWriteLocker lk(&_dis_lock);
+        if (!osjson.is_null() && osjson.has_member("uuid")) {
+            fastring uid = osjson.get("uuid").as_string();
+            auto it = _dis_node_maps.find(uid);
+            if (it != _dis_node_maps.end())
+                _dis_node_maps.erase(it);
+            _dis_node_maps.insert(uid, std::make_pair(result.data, true));
+        } else {
+            WLOG << "searched node has no uuid: " << ip.toStdString();
+        }
+        notifyNodeChanged(true, result.data.c_str());
+    }
     ev.result = true;
     ev.msg = result.data;
     auto req = ev.as_json();
@@ -268,6 +286,11 @@ void DiscoveryJob::handleUpdPackage(const QString &ip, const QString &msg)
             handle_message(msg.toStdString(), ip.toStdString(), false);
 }
 
+void DiscoveryJob::notifyNodeChanged(bool found, const QString &info)
+{
+    emit sigNodeChanged(found, info, ++_nodes_version);
+}
+
 void DiscoveryJob::compareOldAndNew(const fastring &uid, const QString &cur,
                                     const co::lru_map<fastring, std::pair<fastring, bool>>::iterator &it)
 {
@@ -280,12 +303,12 @@ void DiscoveryJob::compareOldAndNew(const fastring &uid, const QString &cur,
 
     if (!oldInfo.apps.empty() && curInfo.apps.empty()) {
         //node has been unregister or losted.
-        emit sigNodeChanged(false, cur);
+        notifyNodeChanged(false, cur);
         _dis_node_maps.erase(it);
     } else if (oldInfo.apps.empty() && !curInfo.apps.empty()){
         //node info has been updated, force update now.
         _dis_node_maps.erase(it);
-        emit sigNodeChanged(true, cur);
+        notifyNodeChanged(true, cur);
         _dis_node_maps.insert(uid, std::make_pair(cur.toStdString(), true));
     } else if (!oldInfo.apps.empty() && !curInfo.apps.empty()) {
         QMap<QString, fastring> oldname, curname;
@@ -305,7 +328,7 @@ void DiscoveryJob::compareOldAndNew(const fastring &uid, const QString &cur,
         }
         if (down) {
             //node has been unregister or losted.
-            emit sigNodeChanged(false, cur);
+            notifyNodeChanged(false, cur);
             _dis_node_maps.erase(it);
         }
 
@@ -321,7 +344,7 @@ void DiscoveryJob::compareOldAndNew(const fastring &uid, const QString &cur,
             //node info has been updated, force update now.
             if (!down)
                 _dis_node_maps.erase(it);
-            emit sigNodeChanged(true, cur);
+            notifyNodeChanged(true, cur);
             _dis_node_maps.insert(uid, std::make_pair(cur.toStdString(), true));
         }
     }
@@ -10,6 +10,8 @@
 #include <co/stl.h>
 #include <QMutex>
 
+#include <atomic>
+
 class DiscoveryJob : public QObject
 {
     Q_OBJECT
@@ -25,7 +27,8 @@ public:
     void removeAppbyName(const fastring name);
     fastring baseInfo() const;
 
-    co::list<fastring> getNodes();
+    // version receives the discovery version the returned nodes match
+    co::list<fastring> getNodes(int *version = nullptr);
 
     static DiscoveryJob *instance()
     {
@@ -42,9 +45,10 @@ public:
     void handleUpdPackage(const QString &ip, const QString &msg);
 
 signals:
-    void sigNodeChanged(bool found, QString info);
+    void sigNodeChanged(bool found, QString info, int version);
 
 private:
+    void notifyNodeChanged(bool found, const QString &info);
     void compareOldAndNew(const fastring &uid, const QString &cur,
                           const co::lru_map<fastring, std::pair<fastring, bool>>::iterator &it);
 
@@ -57,6 +61,8 @@ private:
     //<uuid, <peerinfo, exist>>
     QReadWriteLock _dis_lock;
     co::lru_map<fastring, std::pair<fastring, bool>> _dis_node_maps;
+    // bumped on every node change, frontends use it to resync
+    std::atomic_int _nodes_version { 0 };
     mutable QMutex _lock;
 };
 
@@ -11,6 +11,14 @@
 #include "co/log.h"
 #include "co/path.h"
 
+#include <algorithm>
+
+#ifdef linux
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 //using namespace deamon_core;
 
 FSAdapter::FSAdapter(QObject *parent)
@@ -135,7 +143,9 @@ bool FSAdapter::writeBlock(const char *name, int64 seek_len,
         return false;
     }
     bool write = true;
-    if (size != 0) {
+    if (flags & JobTransFileOp::FILE_HOLE) {
+        write = writeHole(name, seek_len, static_cast<int64>(size));
+    } else if (size != 0) {
         size_t wirted_size = 0;
         size_t rem_size = size;
         (*fx)->seek(seek_len);
@@ -160,6 +170,64 @@ bool FSAdapter::writeBlock(const char *name, int64 seek_len,
     return write;
 }
 
+int64 FSAdapter::nextDataOffset(int fd, int64 offset, int64 end)
+{
+#ifdef linux
+    if (fd < 0)
+        return offset;
+
+    off_t data = lseek(fd, static_cast<off_t>(offset), SEEK_DATA);
+    if (data < 0) {
+        // ENXIO: offset之后没有数据；其它错误按数据处理
+        return errno == ENXIO ? end : offset;
+    }
+    return static_cast<int64>(data);
+#else
+    (void)fd;
+    (void)end;
+    return offset;
+#endif
+}
+
+bool FSAdapter::writeHole(const char *name, int64 seek_len, int64 size)
+{
+    // 文件末尾之后的空洞由后续写入自然留下，只需清掉已有文件中的旧数据
+    int64 file_size = fs::fsize(name);
+    if (size <= 0 || seek_len >= file_size)
+        return true;
+
+    int64 len = std::min(size, file_size - seek_len);
+#if defined(linux) && defined(FALLOC_FL_PUNCH_HOLE)
+    int fd = ::open(name, O_WRONLY);
+    if (fd >= 0) {
+        int ret = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                            static_cast<off_t>(seek_len), static_cast<off_t>(len));
+        ::close(fd);
+        if (ret == 0)
+            return true;
+    }
+#endif
+
+    // 不支持打洞时写零
+    fs::file fx(name, 'm');
+    if (!fx.exists()) {
+        ELOG << "writeHole File does not exist: " << name;
+        return false;
+    }
+    fastring zero(BLOCK_SIZE, '\0');
+    fx.seek(seek_len);
+    while (len > 0) {
+        size_t wsize = fx.write(zero.data(), static_cast<size_t>(std::min<int64>(len, zero.size())));
+        if (wsize <= 0) {
+            ELOG << "writeHole write zero failed: " << name;
+            return false;
+        }
+        len -= static_cast<int64>(wsize);
+    }
+    fx.close();
+    return true;
+}
+
 bool FSAdapter::reacquirePath(fastring filepath, fastring *newpath)
 {
     if (!fs::exists(filepath)) {
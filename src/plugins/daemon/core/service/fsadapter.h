@@ -25,6 +25,9 @@ public:
     static bool writeBlock(const char *name, int64 seek_len, const char *data, size_t size,
                            const int flags, fs::file **fx);
     static bool reacquirePath(fastring filepath, fastring *newpath);
+    // 从offset开始的下一个数据区位置，之后全是空洞时返回end
+    static int64 nextDataOffset(int fd, int64 offset, int64 end);
+    static bool writeHole(const char *name, int64 seek_len, int64 size);
 
 signals:
 
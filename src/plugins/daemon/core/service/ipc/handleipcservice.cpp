@@ -289,8 +289,11 @@ void HandleIpcService::handleNodeRegister(bool unreg, const co::Json &info)
 
 void HandleIpcService::handleGetAllNodes(const QSharedPointer<BackendService> _backendIpcService)
 {
-    auto nodes = DiscoveryJob::instance()->getNodes();
+    int version = 0;
+    auto nodes = DiscoveryJob::instance()->getNodes(&version);
     NodeList nodeInfos;
+    nodeInfos.code = 0;
+    nodeInfos.version = version;
     for (const auto &node : nodes) {
         co::Json nodejs;
         nodejs.parse_from(node);
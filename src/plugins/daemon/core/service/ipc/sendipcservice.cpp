@@ -165,7 +165,7 @@ void SendIpcWork::handleSendToAllClient(const QString req)
         handleSendToClient(appName, req);
 }
 
-void SendIpcWork::handleNodeChanged(bool found, QString info)
+void SendIpcWork::handleNodeChanged(bool found, QString info, int version)
 {
     // notify to all frontend sessions
     for (auto i = _sessions.begin(); i != _sessions.end();) {
@@ -181,9 +181,9 @@ void SendIpcWork::handleNodeChanged(bool found, QString info)
 
 
             co::Json req, res;
-            //cbPeerInfo {GenericResult}
+            //cbPeerInfo {GenericResult}, id is the discovery version
             req = {
-                { "id", 0 },
+                { "id", version },
                 { "result", found ? 1 : 0 },
                 { "msg", nodeinfo },
             };
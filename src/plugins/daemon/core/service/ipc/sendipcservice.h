@@ -32,7 +32,7 @@ private slots:
     void handleAddJob(const QString appName, const int jobID);
     void handleRemoveJob(const QString appName, const int jobID);
     void handleSendToAllClient(const QString req);
-    void handleNodeChanged(bool found, QString info);
+    void handleNodeChanged(bool found, QString info, int version);
     void handlebackendOnline();
     void handlePing();
 
@@ -64,7 +64,7 @@ signals:
     void addJob(const QString appName, const int jobId);
     void removeJob(const QString appName, const int jobId);
     void sendToAllClient(const QString req);
-    void nodeChanged(bool found, QString info);
+    void nodeChanged(bool found, QString info, int version);
     void backendOnline();
     void pingFront();
 
@@ -19,6 +19,11 @@
 #include <QElapsedTimer>
 #include <QStorageInfo>
 
+#ifdef linux
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 TransferJob::TransferJob(QObject *parent)
     : QObject(parent)
 {
@@ -577,6 +582,15 @@ void TransferJob::readFileBlock(fastring filepath, int fileid, const fastring su
     char *buf = reinterpret_cast<char *>(malloc(block_len));
     size_t resize = 0;
     bool open = true;
+
+    // 稀疏文件只发送数据区，整块的空洞用FILE_HOLE描述
+    // 最后一块总是带数据发送，接收端文件大小由它确定
+    const int64 last_block = (file_size - 1) / static_cast<int64>(block_size) * static_cast<int64>(block_size);
+#ifdef linux
+    int hole_fd = ::open(filepath.c_str(), O_RDONLY);
+#else
+    int hole_fd = -1;
+#endif
     do {
         // 最多100个数据块->100M 限制内存使用
         if (self && self->queueCount() > 100) {
@@ -587,6 +601,26 @@ void TransferJob::readFileBlock(fastring filepath, int fileid, const fastring su
         if (self.isNull() || self->_status >= STOPED)
             break;
 
+        int64 hole_end = FSAdapter::nextDataOffset(hole_fd, read_size, file_size);
+        hole_end = std::min(hole_end / static_cast<int64>(block_size) * static_cast<int64>(block_size), last_block);
+        if (hole_end > read_size) {
+            QSharedPointer<FSDataBlock> block(new FSDataBlock);
+            block->job_id = self->_jobid;
+            block->file_id = fileid;
+            block->rootdir = root;
+            block->filename = subname;
+            block->blk_id = block_id;
+            block->flags = (open ? JobTransFileOp::FIlE_CREATE : JobTransFileOp::FIlE_NONE) | JobTransFileOp::FILE_HOLE;
+            block->data_size = hole_end - read_size;
+            self->pushQueque(block);
+            open = false;
+
+            block_id += static_cast<uint32>((hole_end - read_size) / static_cast<int64>(block_size));
+            read_size = hole_end;
+            fd.seek(read_size);
+            continue;
+        }
+
         memset(buf, 0, block_len);
         resize = fd.read(buf, block_size);
         if (resize > block_size) {
@@ -624,6 +658,10 @@ void TransferJob::readFileBlock(fastring filepath, int fileid, const fastring su
 
     free(buf);
     fd.close();
+#ifdef linux
+    if (hole_fd >= 0)
+        ::close(hole_fd);
+#endif
 }
 
 bool TransferJob::writeAndCreateFile(const QSharedPointer<FSDataBlock> block, const fastring fullpath)
@@ -649,14 +687,16 @@ bool TransferJob::writeAndCreateFile(const QSharedPointer<FSDataBlock> block, co
     }
 
     fastring buffer = block->data;
-    size_t len = buffer.size();
-    int64 offset = static_cast<int64>(block->blk_id * BLOCK_SIZE);
+    // 空洞块不带数据，长度是data_size
+    bool hole = block->flags & JobTransFileOp::FILE_HOLE;
+    size_t len = hole ? static_cast<size_t>(block->data_size) : buffer.size();
+    int64 offset = static_cast<int64>(block->blk_id) * BLOCK_SIZE;
     // ELOG << "file : " << name << " write : " << len << " totol = " << _total_size << " curent " <<  _cur_size
     //      << "  flags !!! " << block->flags;
     int count = 3;
     bool good = false;
     do {
-        good = FSAdapter::writeBlock(fullpath.c_str(), offset, buffer.c_str(), len, block->flags, &fx);
+        good = FSAdapter::writeBlock(fullpath.c_str(), offset, hole ? nullptr : buffer.c_str(), len, block->flags, &fx);
         count--;
     } while(!good && count > 0);
 
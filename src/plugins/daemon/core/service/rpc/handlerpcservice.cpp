@@ -25,7 +25,8 @@
 #include <QCoreApplication>
 
 co::chan<IncomeData> _income_chan(10, 300);
-co::chan<OutData> _outgo_chan(10, 20);
+// 文件传输相关的请求按到达顺序逐个处理
+static co::chan<IncomeData> _file_chan(32, 300);
 HandleRpcService::HandleRpcService(QObject *parent)
     : QObject(parent)
 {
@@ -45,6 +46,17 @@ void HandleRpcService::startRemoteServer()
 {
     startRemoteServer(UNI_RPC_PORT_BASE);
     startRemoteServer(UNI_RPC_PORT_TRANS);
+
+    QPointer<HandleRpcService> self = this;
+    UNIGO([self]() {
+        while (!self.isNull()) {
+            IncomeData indata;
+            _file_chan >> indata;
+            if (!_file_chan.done())
+                continue;
+            self->handleIncome(indata);
+        }
+    });
 }
 
 void HandleRpcService::handleRpcLogin(bool result, const QString &targetAppname,
@@ -107,7 +119,7 @@ bool HandleRpcService::handleRemoteApplyTransFile(co::Json &info)
     return true;
 }
 
-bool HandleRpcService::handleRemoteLogin(co::Json &info)
+bool HandleRpcService::handleRemoteLogin(co::Json &info, const ReplyChan &reply)
 {
     UserLoginInfo lo;
     lo.from_json(info);
@@ -172,7 +184,7 @@ bool HandleRpcService::handleRemoteLogin(co::Json &info)
     OutData data;
     data.type = LOGIN_INFO;
     data.json = lores.as_json().str();
-    _outgo_chan << data;
+    *reply << data;
 
     return true;
 }
@@ -188,7 +200,7 @@ void HandleRpcService::handleRemoteDisc(co::Json &info)
     SendIpcService::instance()->handleSendToClient(mis.app.c_str(), msg.str().c_str());
 }
 
-void HandleRpcService::handleRemoteFileBlock(co::Json &info, fastring data)
+void HandleRpcService::handleRemoteFileBlock(co::Json &info, fastring data, const ReplyChan &reply)
 {
     FileTransResponse reply;
     auto res = JobManager::instance()->handleFSData(info, data, &reply);
@@ -197,10 +209,10 @@ void HandleRpcService::handleRemoteFileBlock(co::Json &info, fastring data)
     out.type = FS_DATA;
     reply.result = (res ? OK : IO_ERROR);
     out.json = reply.as_json().str();
-    _outgo_chan << out;
+    *reply << out;
 }
 
-void HandleRpcService::handleRemoteReport(co::Json &info)
+void HandleRpcService::handleRemoteReport(co::Json &info, const ReplyChan &reply)
 {
     FileTransResponse reply;
     reply.result = OK;
@@ -209,10 +221,10 @@ void HandleRpcService::handleRemoteReport(co::Json &info)
 
     JobManager::instance()->handleTransReport(info, &reply);
     out.json = reply.as_json().str();
-    _outgo_chan << out;
+    *reply << out;
 }
 
-void HandleRpcService::handleRemoteJobCancel(co::Json &info)
+void HandleRpcService::handleRemoteJobCancel(co::Json &info, const ReplyChan &reply)
 {
     FileTransResponse reply;
     reply.result = OK;
@@ -222,10 +234,10 @@ void HandleRpcService::handleRemoteJobCancel(co::Json &info)
     JobManager::instance()->handleCancelJob(info, &reply);
     Comshare::instance()->updateStatus(CURRENT_STATUS_DISCONNECT);
     out.json = reply.as_json().str();
-    _outgo_chan << out;
+    *reply << out;
 }
 
-void HandleRpcService::handleTransJob(co::Json &info)
+void HandleRpcService::handleTransJob(co::Json &info, const ReplyChan &reply)
 {
     QString app;
     bool res = false;
@@ -246,7 +258,7 @@ void HandleRpcService::handleTransJob(co::Json &info)
     OutData data;
     data.type = TRANSJOB;
     data.json = reply.as_json().str();
-    _outgo_chan << data;
+    *reply << data;
 }
 
 void HandleRpcService::handleRemoteShareConnect(co::Json &info)
@@ -460,16 +472,16 @@ bool HandleRpcService::checkConnected()
     return _rpc->checkConneted() || _rpc_trans->checkConneted();
 }
 
-void HandleRpcService::handleRemoteSearchIp(co::Json &info)
+void HandleRpcService::handleRemoteSearchIp(co::Json &info, const ReplyChan &reply)
 {
     Q_UNUSED(info);
     OutData data;
     data.type = SEARCH_DEVICE_BY_IP;
     data.json = DiscoveryJob::instance()->nodeInfoStr();
-    _outgo_chan << data;
+    *reply << data;
 }
 
-void HandleRpcService::hanldeRemoteDiscover(co::Json &info)
+void HandleRpcService::hanldeRemoteDiscover(co::Json &info, const ReplyChan &reply)
 {
     DiscoverInfo dis, res;
     OutData data;
@@ -477,7 +489,7 @@ void HandleRpcService::hanldeRemoteDiscover(co::Json &info)
     res.ip = Util::getFirstIp();
     res.msg = DiscoveryJob::instance()->udpSendPackage();
     data.json = res.as_json().str();
-    _outgo_chan << data;
+    *reply << data;
 
     dis.from_json(info);
     DiscoveryJob::instance()->handleUpdPackage(dis.ip.c_str(), dis.msg.c_str());
@@ -539,169 +551,186 @@ void HandleRpcService::startRemoteServer(const quint16 port)
                 continue;
             }
             LOG_IF(FLG_log_detail) << ">> get chan value: " << indata.type << " json:" << indata.json;
-            co::Json json_obj = json::parse(indata.json);
-            if (json_obj.is_null()) {
-                ELOG << "parse error from: " << indata.json;
-                continue;
-            }
             switch (indata.type) {
-            case LOGIN_INFO:
-            {
-                self->handleRemoteLogin(json_obj);
-                break;
-            }
-            case LOGIN_CONFIRM:
-            {
-                //TODO: notify user confirm login
-                break;
-            }
-            case LOGIN_RESULT:// 服务器端回复登陆结果
-            {
-                break;
-            }
             case TRANSJOB:
-            {
-                self->handleTransJob(json_obj);
-                break;
-            }
             case FS_DATA:
-            {
-                // must update the binrary data into struct object.
-                self->handleRemoteFileBlock(json_obj, indata.buf);
-                break;
-            }
             case TRANS_CANCEL:
-            {
-                self->handleRemoteJobCancel(json_obj);
-                break;
-            }
             case FS_REPORT:
-            {
-                self->handleRemoteReport(json_obj);
-                break;
-            }
-            case TRANS_APPLY:
-            {
-                OutData data;
-                data.type = TRANS_APPLY;
-                _outgo_chan << data;
-                self->handleRemoteApplyTransFile(json_obj);
-                break;
-            }
-            case MISC:
-            {
-                OutData data;
-                data.type = MISC;
-                _outgo_chan << data;
-                self->handleRemoteDisc(json_obj);
-                break;
-            }
-            case RPC_PING:
-            {
-                PingPong pong;
-                pong.ip = Util::getFirstIp();
-                OutData data;
-                data.type = RPC_PING;
-                data.json = pong.as_json().str();
-                _outgo_chan << data;
-                if (self)
-                    self->handleRemotePing(json_obj);
-                break;
-            }
-            case APPLY_SHARE_CONNECT:
-            {
-                // 被控制方收到共享连接申请
-                OutData data;
-                data.type = APPLY_SHARE_DISCONNECT;
-                _outgo_chan << data;
-                self->handleRemoteShareConnect(json_obj);
-                break;
-            }
-            case APPLY_SHARE_DISCONNECT: {
-                // 被控制方收到共享连接申请
-                OutData data;
-                data.type = APPLY_SHARE_DISCONNECT;
-                _outgo_chan << data;
-                self->handleRemoteShareDisConnect(json_obj);
-                break;
-            }
-            case APPLY_SHARE_CONNECT_RES:
-            {
-                // 控制方收到被控制方申请共享连接的回复
-                OutData data;
-                data.type = APPLY_SHARE_CONNECT_RES;
-                _outgo_chan << data;
-                self->handleRemoteShareConnectReply(json_obj);
-                break;
-            }
-            case SHARE_START:
-            {
-                // 被控制方收到控制方的开始共享
-                OutData data;
-                data.type = SHARE_START;
-                _outgo_chan << data;
-                self->handleRemoteShareStart(json_obj);
-                break;
-            }
-            case SHARE_START_RES:
-            {
-                // 被控制方收到控制方的开始共享
-                OutData data;
-                data.type = SHARE_START_RES;
-                _outgo_chan << data;
-                self->handleRemoteShareStartRes(json_obj);
-                break;
-            }
-            case SHARE_STOP:
-            {
-                // 被控制方收到控制方的开始共享
-                OutData data;
-                data.type = SHARE_STOP;
-                _outgo_chan << data;
-                self->handleRemoteShareStop(json_obj);
-                break;
-            }
-            case DISCONNECT_CB:
-            {
-                // 断开连接
-                OutData data;
-                data.type = DISCONNECT_CB;
-                _outgo_chan << data;
-                self->handleRemoteDisConnectCb(json_obj);
-                break;
-            }
-            case DISAPPLY_SHARE_CONNECT:
-            {
-                // 断开连接
-                OutData data;
-                data.type = DISAPPLY_SHARE_CONNECT;
-                _outgo_chan << data;
-                self->handleRemoteDisApplyShareConnect(json_obj);
-                break;
-            }
-            case SEARCH_DEVICE_BY_IP:
-            {
-                if (self)
-                    self->handleRemoteSearchIp(json_obj);
-                break;
-            }
-            case DISCOVER_BY_TCP:
-            {
-                if (self)
-                    self->hanldeRemoteDiscover(json_obj);
+                // 文件块要按顺序写入，交给文件队列
+                _file_chan << indata;
                 break;
-            }
-            default:{
-                OutData data;
-                data.type = UNKOWN;
-                _outgo_chan << data;
+            default:
+                // 其他请求互不依赖，各自处理，心跳不会排在慢请求之后
+                UNIGO([self, indata]() {
+                    if (!self.isNull())
+                        self->handleIncome(indata);
+                });
                 break;
             }
-            }
         }
     });
 }
 
+void HandleRpcService::handleIncome(const IncomeData &indata)
+{
+    co::Json json_obj = json::parse(indata.json);
+    if (json_obj.is_null()) {
+        ELOG << "parse error from: " << indata.json;
+        return;
+    }
+    switch (indata.type) {
+    case LOGIN_INFO:
+    {
+        handleRemoteLogin(json_obj, indata.reply);
+        break;
+    }
+    case LOGIN_CONFIRM:
+    {
+        //TODO: notify user confirm login
+        break;
+    }
+    case LOGIN_RESULT:// 服务器端回复登陆结果
+    {
+        break;
+    }
+    case TRANSJOB:
+    {
+        handleTransJob(json_obj, indata.reply);
+        break;
+    }
+    case FS_DATA:
+    {
+        // must update the binrary data into struct object.
+        handleRemoteFileBlock(json_obj, indata.buf, indata.reply);
+        break;
+    }
+    case TRANS_CANCEL:
+    {
+        handleRemoteJobCancel(json_obj, indata.reply);
+        break;
+    }
+    case FS_REPORT:
+    {
+        handleRemoteReport(json_obj, indata.reply);
+        break;
+    }
+    case TRANS_APPLY:
+    {
+        OutData data;
+        data.type = TRANS_APPLY;
+        *indata.reply << data;
+        handleRemoteApplyTransFile(json_obj);
+        break;
+    }
+    case MISC:
+    {
+        OutData data;
+        data.type = MISC;
+        *indata.reply << data;
+        handleRemoteDisc(json_obj);
+        break;
+    }
+    case RPC_PING:
+    {
+        PingPong pong;
+        pong.ip = Util::getFirstIp();
+        OutData data;
+        data.type = RPC_PING;
+        data.json = pong.as_json().str();
+        *indata.reply << data;
+        handleRemotePing(json_obj);
+        break;
+    }
+    case APPLY_SHARE_CONNECT:
+    {
+        // 被控制方收到共享连接申请
+        OutData data;
+        data.type = APPLY_SHARE_DISCONNECT;
+        *indata.reply << data;
+        handleRemoteShareConnect(json_obj);
+        break;
+    }
+    case APPLY_SHARE_DISCONNECT: {
+        // 被控制方收到共享连接申请
+        OutData data;
+        data.type = APPLY_SHARE_DISCONNECT;
+        *indata.reply << data;
+        handleRemoteShareDisConnect(json_obj);
+        break;
+    }
+    case APPLY_SHARE_CONNECT_RES:
+    {
+        // 控制方收到被控制方申请共享连接的回复
+        OutData data;
+        data.type = APPLY_SHARE_CONNECT_RES;
+        *indata.reply << data;
+        handleRemoteShareConnectReply(json_obj);
+        break;
+    }
+    case SHARE_START:
+    {
+        // 被控制方收到控制方的开始共享
+        OutData data;
+        data.type = SHARE_START;
+        *indata.reply << data;
+        handleRemoteShareStart(json_obj);
+        break;
+    }
+    case SHARE_START_RES:
+    {
+        // 被控制方收到控制方的开始共享
+        OutData data;
+        data.type = SHARE_START_RES;
+        *indata.reply << data;
+        handleRemoteShareStartRes(json_obj);
+        break;
+    }
+    case SHARE_STOP:
+    {
+        // 被控制方收到控制方的开始共享
+        OutData data;
+        data.type = SHARE_STOP;
+        *indata.reply << data;
+        handleRemoteShareStop(json_obj);
+        break;
+    }
+    case DISCONNECT_CB:
+    {
+        // 断开连接
+        OutData data;
+        data.type = DISCONNECT_CB;
+        *indata.reply << data;
+        handleRemoteDisConnectCb(json_obj);
+        break;
+    }
+    case DISAPPLY_SHARE_CONNECT:
+    {
+        // 断开连接
+        OutData data;
+        data.type = DISAPPLY_SHARE_CONNECT;
+        *indata.reply << data;
+        handleRemoteDisApplyShareConnect(json_obj);
+        break;
+    }
+    case SEARCH_DEVICE_BY_IP:
+    {
+        handleRemoteSearchIp(json_obj, indata.reply);
+        break;
+    }
+    case DISCOVER_BY_TCP:
+    {
+        hanldeRemoteDiscover(json_obj, indata.reply);
+        break;
+    }
+    default:{
+        OutData data;
+        data.type = UNKOWN;
+        *indata.reply << data;
+        break;
+    }
+    }
+}
+
 void HandleRpcService::handleTimeOut()
 {
     QWriteLocker lk(&_lock);
@@ -13,6 +13,7 @@
 
 #include "co/co.h"
 #include "co/json.h"
+#include "service/comshare.h"
 
 class RemoteServiceBinder;
 class HandleRpcService : public QObject
@@ -27,12 +28,12 @@ public:
     void handleRpcLogin(bool result,const QString &targetAppname,
                         const QString &appName, const QString &ip);
     bool handleRemoteApplyTransFile(co::Json &info);
-    bool handleRemoteLogin(co::Json &info);
+    bool handleRemoteLogin(co::Json &info, const ReplyChan &reply);
     void handleRemoteDisc(co::Json &info);
-    void handleRemoteFileBlock(co::Json &info, fastring data);
-    void handleRemoteReport(co::Json &info);
-    void handleRemoteJobCancel(co::Json &info);
-    void handleTransJob(co::Json &info);
+    void handleRemoteFileBlock(co::Json &info, fastring data, const ReplyChan &reply);
+    void handleRemoteReport(co::Json &info, const ReplyChan &reply);
+    void handleRemoteJobCancel(co::Json &info, const ReplyChan &reply);
+    void handleTransJob(co::Json &info, const ReplyChan &reply);
     void handleRemoteShareConnect(co::Json &info);
     void handleRemoteShareDisConnect(co::Json &info);
     void handleRemoteShareConnectReply(co::Json &info);
@@ -44,10 +45,11 @@ public:
     void handleRemoteDisApplyShareConnect(co::Json &info);
     // 检查51597和51599两个端口是否有连接阻塞，没有退出
     bool checkConnected();
-    void handleRemoteSearchIp(co::Json &info);
-    void hanldeRemoteDiscover(co::Json &info);
+    void handleRemoteSearchIp(co::Json &info, const ReplyChan &reply);
+    void hanldeRemoteDiscover(co::Json &info, const ReplyChan &reply);
 
 private:
+    void handleIncome(const IncomeData &indata);
     void handleOffline(const QString ip);
     void startRemoteServer(const quint16 port);
 
@@ -32,6 +32,11 @@ static QMap<QString, QSharedPointer<ZRpcClientExecutor>> _executor_ps;
 // 一个ip只能有一个文件传输发送者,并且使用完成后必须清理
 static QMap<QString, QSharedPointer<ZRpcClientExecutor>> _executor_long_ps;
 
+// 等待本请求处理结果的最长时间
+static const uint32 kReplyTimeout = 5000;
+// 一个连接上同时处理的请求数，心跳等不再被慢请求阻塞
+static const int kMaxInflight = 8;
+
 void RemoteServiceImpl::proto_msg(google::protobuf::RpcController *controller,
                                   const ProtoData *request, ProtoData *response,
                                   google::protobuf::Closure *done)
@@ -43,15 +48,15 @@ void RemoteServiceImpl::proto_msg(google::protobuf::RpcController *controller,
     in.json = request->msg();
     std::string buffer = request->data();
     in.buf = buffer;
+    in.reply = std::make_shared<co::chan<OutData>>(1, kReplyTimeout);
     _income_chan << in;
 
+    // 请求可能并发执行，回复只从本请求的通道读取
     OutData out;
-    _outgo_chan >> out;
-    if (in.type != out.type) {
-        WLOG << "RPC response not match type:" << in.type << " != " << out.type;
-        // skip this, try next data
-        _outgo_chan >> out;
-        if (in.type != out.type) return;
+    *in.reply >> out;
+    if (!in.reply->done()) {
+        WLOG << "RPC response timeout, type:" << in.type;
+        return;
     }
     response->set_type(out.type);
     response->set_msg(out.json.c_str());
@@ -229,8 +234,13 @@ void RemoteServiceBinder::startRpcListen(const char *keypath, const char *crtpat
     char crt[1024];
     strcpy(key, keypath);
     strcpy(crt, crtpath);
+    const fastring &congestion = DaemonConfig::instance()->getTcpCongestion();
+    if (!congestion.empty())
+        zrpc_ns::setCongestionControl(congestion.c_str());
+
     server = new zrpc_ns::ZRpcServer(port, key, crt);
     server->registerService<RemoteServiceImpl>();
+    server->setMaxInflight(kMaxInflight);
     if (call) {
         callback = call;
         server->setCallBackFunc(callback);
@@ -22,6 +22,7 @@
 #define KEY_NICKNAME "nickname"
 #define KEY_MODE "privacymode"
 #define KEY_AUTHPIN "authpin"
+#define KEY_TCPCONGESTION "tcpcongestion"
 
 class DaemonConfig
 {
@@ -136,6 +137,13 @@ public:
         _fileConfig->setValue(KEY_MODE, mode);
     }
 
+    // 传输连接使用的拥塞控制算法，如 bbr，为空时使用系统默认
+    const fastring getTcpCongestion() {
+        QReadLocker lk(&_config_mutex);
+        QString name = _fileConfig->value(KEY_TCPCONGESTION).toString();
+        return name.toStdString();
+    }
+
     void saveRemoteSession(fastring session)
     {
         _remote_sessionId = session;
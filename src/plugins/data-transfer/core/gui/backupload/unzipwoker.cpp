@@ -1,18 +1,44 @@
 #include "unzipwoker.h"
 
-#include <QProcess>
 #include <QDebug>
 #include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDir>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
 #include <utils/transferhepler.h>
+#include <utils/settinghepler.h>
+#include <utils/optionsmanager.h>
+#include <utils/backgroundpriority.h>
 
-#include <QTimer>
 #include <zip.h>
 
+#include <functional>
+
 inline constexpr char datajson[] { "transfer.json" };
+inline constexpr char kBackupManifest[] { "backup-manifest.json" };
+
+// Size of the read/write buffer owned by every extracting thread
+inline constexpr int kExtractBufferSize { 4 * 1024 * 1024 };
+// Minimum interval between two progress updates sent to the UI
+inline constexpr int kProgressIntervalMs { 250 };
+inline constexpr int kMaxExtractThreads { 4 };
+
+class UnzipTask : public QRunnable
+{
+public:
+    explicit UnzipTask(std::function<void()> func)
+        : func(std::move(func)) {}
+    void run() override { func(); }
+
+private:
+    std::function<void()> func;
+};
 
 UnzipWorker::UnzipWorker(QString filepath)
     : filepath(filepath)
@@ -22,15 +48,7 @@ UnzipWorker::UnzipWorker(QString filepath)
     while (QFile::exists(targetDir)) {
         targetDir = targetDir + "tmp";
     }
-    count = getNumFiles(filepath);
-    timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, [this]() {
-        speed = currentTotal - previousTotal + 1;
-        previousTotal = currentTotal;
-    });
-
-    //Calculate transmission speed
-    timer->start(500);
+    background = OptionsManager::instance()->getUserOption(Options::kFullSpeed).value(0) != "true";
 }
 
 UnzipWorker::~UnzipWorker()
@@ -39,28 +57,13 @@ UnzipWorker::~UnzipWorker()
 
 void UnzipWorker::run()
 {
+    BackgroundPriority priority(background);
+
     //decompression
     extract();
 
     //configuration
-    TransferHelper::instance()->setting(targetDir);
-}
-
-int UnzipWorker::getNumFiles(QString filepath)
-{
-    const char *zipFilePath = filepath.toLocal8Bit().constData();
-    struct zip *archive = zip_open(zipFilePath, 0, NULL);
-
-    if (archive) {
-        int fileCount = zip_get_num_files(archive);
-        LOG << "Number of files in ZIP file:" << fileCount;
-
-        zip_close(archive);
-        return fileCount;
-    } else {
-        LOG << "Unable to open ZIP file";
-        return 0;
-    }
+    TransferHelper::instance()->setting(targetDir, filesPlaced);
 }
 
 bool UnzipWorker::isValid(QString filepath)
@@ -108,78 +111,289 @@ bool UnzipWorker::isValid(QString filepath)
 
 bool UnzipWorker::extract()
 {
+    emit TransferHelper::instance()->transferContent(tr("Decompressing"), targetDir, 0, 0);
 
-    QStringList arguments;
-    arguments << "-O"
-              << "utf-8"
-              << filepath
-              << "-d"
-              << targetDir;
+    if (!readEntries())
+        return false;
 
-    QProcess process;
-    process.setReadChannel(QProcess::StandardOutput);
-    process.setReadChannelMode(QProcess::SeparateChannels);
-    process.start("unzip", arguments);
+    // libzip handles are not thread safe, so every extracting thread opens
+    // the archive on its own and pulls the next entry from the shared index.
+    QThreadPool pool;
+    int threads = qBound(1, QThread::idealThreadCount(), kMaxExtractThreads);
+    threads = qMin(threads, qMax(1, entries.size()));
+    pool.setMaxThreadCount(threads);
+    for (int i = 0; i < threads; ++i)
+        pool.start(new UnzipTask([this]() { extractEntries(); }));
 
-    //    LOG << process.arguments().toStdList();
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (!pool.waitForDone(kProgressIntervalMs))
+        reportProgress(elapsed.elapsed());
 
-    emit TransferHelper::instance()->transferContent(tr("Decompressing"), targetDir, 0, 0);
+    LOG << "decompress finished, files:" << entries.size() << " bytes:" << extractedBytes.load()
+        << " failed:" << failedEntries.load() << " cost(ms):" << elapsed.elapsed();
+
+    QStringList succeeded, failed;
+    for (const UserFile &file : userFiles)
+        (file.failed ? failed : succeeded).append(QFileInfo(file.path).fileName());
+    if (!succeeded.isEmpty())
+        emit TransferHelper::instance()->addResults(succeeded, true, SettingHelper::tr("Transfer completed"));
+    if (!failed.isEmpty())
+        emit TransferHelper::instance()->addResults(failed, false, SettingHelper::tr("Transfer failed"));
+    return failedEntries.load() == 0;
+}
 
-    while (process.waitForReadyRead(100000)) {
-        QByteArray output = process.readAllStandardOutput();
-        QString outputText = QString::fromLocal8Bit(output);
-        if (outputText.startsWith("  inflating: ")) {
-            outputText = outputText.mid(outputText.indexOf("inflating:") + QString("inflating:").length() + 1);
-            currentTotal++;
-            double value = static_cast<double>(currentTotal) / count;
-            int progressbar = static_cast<int>(value * 100) - 1;
-            int estimatedtime = (count - currentTotal) / speed / 2 + 1;
-            emit TransferHelper::instance()->transferContent(tr("Decompressing"), outputText, progressbar, estimatedtime);
-            LOG << value << outputText.toStdString();
+static QByteArray readZipEntry(struct zip *archive, const char *name)
+{
+    zip_stat_t st;
+    zip_stat_init(&st);
+    if (zip_stat(archive, name, 0, &st) != 0 || !(st.valid & ZIP_STAT_SIZE))
+        return QByteArray();
+
+    struct zip_file *file = zip_fopen(archive, name, 0);
+    if (!file)
+        return QByteArray();
+    QByteArray data(static_cast<int>(st.size), Qt::Uninitialized);
+    const zip_int64_t bytesRead = zip_fread(file, data.data(), st.size);
+    zip_fclose(file);
+    if (bytesRead != static_cast<zip_int64_t>(st.size))
+        return QByteArray();
+    return data;
+}
+
+bool UnzipWorker::readEntries()
+{
+    int error = 0;
+    const QByteArray archivePath = filepath.toLocal8Bit();
+    struct zip *archive = zip_open(archivePath.constData(), ZIP_RDONLY, &error);
+    if (!archive) {
+        WLOG << "Unable to open ZIP file, error:" << error;
+        return false;
+    }
+
+    // Present in every backup, lists files stored in older backups as well
+    const QJsonObject manifest = QJsonDocument::fromJson(readZipEntry(archive, kBackupManifest)).object();
+    const QJsonObject backupFiles = manifest.value("files").toObject();
+    for (const auto &name : manifest.value("deleted").toArray())
+        deletedFiles.insert(name.toString());
+    filesPlaced = readManifest(archive, backupFiles);
+    const QHash<QString, QStringList> baseFiles = baseArchiveFiles(backupFiles);
+
+    // Walk the central directory once, collecting every directory that has
+    // to exist before any data is written.
+    QSet<QString> dirs;
+    dirs.insert(targetDir);
+    archives.append(filepath);
+    const zip_int64_t num = zip_get_num_entries(archive, 0);
+    entries.reserve(static_cast<int>(num));
+    for (zip_int64_t i = 0; i < num; ++i)
+        addEntry(archive, 0, static_cast<quint64>(i), dirs);
+    zip_close(archive);
+
+    // Files left unchanged by an incremental backup are read from the older
+    // backups next to it, so the whole chain is restored in a single pass.
+    const QDir backupDir = QFileInfo(filepath).dir();
+    for (auto it = baseFiles.constBegin(); it != baseFiles.constEnd(); ++it) {
+        const QByteArray basePath = backupDir.filePath(it.key()).toLocal8Bit();
+        struct zip *base = zip_open(basePath.constData(), ZIP_RDONLY, &error);
+        if (!base) {
+            WLOG << "Unable to open base backup:" << basePath.toStdString() << " error:" << error;
+            for (const QString &name : it.value()) {
+                const int owner = userFileIndex.value(name.section('/', 0, 0), -1);
+                if (owner >= 0)
+                    userFiles[owner].failed = true;
+                failedEntries++;
+            }
+            continue;
+        }
+
+        archives.append(basePath);
+        for (const QString &name : it.value()) {
+            const zip_int64_t index = zip_name_locate(base, name.toUtf8().constData(), 0);
+            if (index < 0) {
+                WLOG << "missing entry in base backup:" << name.toStdString();
+                failedEntries++;
+                continue;
+            }
+            addEntry(base, archives.size() - 1, static_cast<quint64>(index), dirs);
         }
+        zip_close(base);
+    }
+
+    QDir dir;
+    for (const QString &path : dirs) {
+        if (!dir.mkpath(path))
+            WLOG << "could not create dir:" << path.toStdString();
     }
-    if (process.exitCode() != 0)
-        LOG << "Error message:" << process.errorString().toStdString();
-    process.waitForFinished();
+
+    LOG << "Number of files in ZIP file:" << entries.size() << " total bytes:" << totalBytes
+        << " archives:" << archives.size();
     return true;
 }
 
-bool UnzipWorker::set()
+void UnzipWorker::addEntry(struct zip *archive, int archiveIndex, quint64 index, QSet<QString> &dirs)
 {
-    QFile file(targetDir + "/" + datajson);
-    if (!file.open(QIODevice::ReadOnly)) {
-        WLOG << "could not open datajson file";
+    zip_stat_t st;
+    zip_stat_init(&st);
+    if (zip_stat_index(archive, index, 0, &st) != 0 || !(st.valid & ZIP_STAT_NAME))
+        return;
+
+    const QString name = QString::fromUtf8(st.name);
+    const QString cleanName = QDir::cleanPath(name);
+    if (cleanName.startsWith("/") || cleanName == ".." || cleanName.startsWith("../")) {
+        WLOG << "skip unsafe zip entry:" << name.toStdString();
+        return;
+    }
+    if (cleanName == kBackupManifest || deletedFiles.contains(cleanName))
+        return;
+
+    // User files go straight to their destination, everything else is staged
+    const int slash = cleanName.indexOf('/');
+    const int owner = userFileIndex.value(slash < 0 ? cleanName : cleanName.left(slash), -1);
+    const QString target = owner < 0 ? targetDir + "/" + cleanName
+                                     : userFiles.at(owner).target + (slash < 0 ? QString() : cleanName.mid(slash));
+
+    if (name.endsWith('/')) {
+        dirs.insert(target);
+        return;
+    }
+
+    dirs.insert(QFileInfo(target).path());
+    const qint64 size = (st.valid & ZIP_STAT_SIZE) ? static_cast<qint64>(st.size) : 0;
+    const qint64 mtime = (st.valid & ZIP_STAT_MTIME) ? static_cast<qint64>(st.mtime) : -1;
+    entries.append({ archiveIndex, index, cleanName, target, owner, size, mtime });
+    totalBytes += size;
+}
+
+QHash<QString, QStringList> UnzipWorker::baseArchiveFiles(const QJsonObject &backupFiles) const
+{
+    // Entries not stored in this archive, grouped by the archive holding them
+    QHash<QString, QStringList> baseFiles;
+    const QString archiveName = QFileInfo(filepath).fileName();
+    for (auto it = backupFiles.constBegin(); it != backupFiles.constEnd(); ++it) {
+        const QString holder = it.value().toObject().value("archive").toString();
+        if (!holder.isEmpty() && holder != archiveName && !deletedFiles.contains(it.key()))
+            baseFiles[holder].append(it.key());
+    }
+    return baseFiles;
+}
+
+bool UnzipWorker::readManifest(struct zip *archive, const QJsonObject &backupFiles)
+{
+    const QByteArray jsonData = readZipEntry(archive, datajson);
+    if (jsonData.isEmpty()) {
+        WLOG << "Failed to read transfer.json in zip";
         return false;
     }
-    QByteArray jsonData = file.readAll();
-    file.close();
 
     QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData);
     if (jsonDoc.isNull()) {
         WLOG << "Parsing JSON data failed";
         return false;
     }
-    QJsonObject jsonObj = jsonDoc.object();
-
-    //Place the file in the corresponding user directory
-    setUesrFile(jsonObj);
 
+    // Every selected file or folder is stored in the archive under its own
+    // name, so the top level entry name maps to its home relative path.
+    const QJsonArray userFileArray = jsonDoc.object()["user_file"].toArray();
+    for (const auto &value : userFileArray) {
+        const QString path = value.toString();
+        const QString name = QFileInfo(path).fileName();
+        if (name.isEmpty() || userFileIndex.contains(name))
+            continue;
+        const bool isDir = zip_name_locate(archive, name.toUtf8().constData(), 0) < 0
+                && !backupFiles.contains(name);
+        const QString target = SettingHelper::availablePath(QDir::homePath() + "/" + path, isDir);
+        userFileIndex.insert(name, userFiles.size());
+        userFiles.append({ path, target, false });
+    }
     return true;
 }
 
-bool UnzipWorker::setUesrFile(QJsonObject jsonObj)
+void UnzipWorker::extractEntries()
 {
-    QJsonValue userFileValue = jsonObj["user_file"];
-    if (userFileValue.isArray()) {
-        const QJsonArray &userFileArray = userFileValue.toArray();
-        for (const auto &value : userFileArray) {
-            QString file = value.toString();
-            QString targetFile = QDir::homePath() + "/" + file;
-            QString filepath = targetDir + file.mid(file.indexOf('/'));
-            bool success = QFile::rename(filepath, targetFile);
-            LOG << filepath.toStdString() << success;
+    BackgroundPriority priority(background);
+    // One handle per archive, opened on first use
+    QVector<struct zip *> handles(archives.size(), nullptr);
+    QByteArray buffer(kExtractBufferSize, Qt::Uninitialized);
+    int index;
+    while ((index = nextEntry++) < entries.size()) {
+        const Entry &entry = entries.at(index);
+        struct zip *&archive = handles[entry.archive];
+        if (!archive) {
+            int error = 0;
+            const QByteArray archivePath = archives.at(entry.archive).toLocal8Bit();
+            archive = zip_open(archivePath.constData(), ZIP_RDONLY, &error);
+            if (!archive)
+                WLOG << "Unable to open ZIP file, error:" << error;
+        }
+        if (archive && extractEntry(archive, entry, buffer))
+            continue;
+        failedEntries++;
+        if (entry.owner >= 0) {
+            QMutexLocker locker(&userFileMutex);
+            userFiles[entry.owner].failed = true;
         }
     }
-    LOG << jsonObj["user_file"].toString().toStdString();
-    return true;
+    for (struct zip *archive : handles) {
+        if (archive)
+            zip_close(archive);
+    }
+}
+
+bool UnzipWorker::extractEntry(struct zip *archive, const Entry &entry, QByteArray &buffer)
+{
+    struct zip_file *zfile = zip_fopen_index(archive, entry.index, 0);
+    if (!zfile) {
+        WLOG << "Failed to open file in zip:" << entry.name.toStdString();
+        return false;
+    }
+
+    QFile out(entry.target);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        WLOG << "could not open file:" << out.fileName().toStdString();
+        zip_fclose(zfile);
+        return false;
+    }
+
+    bool ok = true;
+    zip_int64_t bytesRead;
+    while ((bytesRead = zip_fread(zfile, buffer.data(), static_cast<zip_uint64_t>(buffer.size()))) > 0) {
+        if (out.write(buffer.constData(), bytesRead) != bytesRead) {
+            WLOG << "write file failed:" << out.fileName().toStdString();
+            ok = false;
+            break;
+        }
+        extractedBytes += bytesRead;
+        if (background)
+            BackgroundPriority::throttle();
+    }
+    if (bytesRead < 0) {
+        WLOG << "read zip entry failed:" << entry.name.toStdString();
+        ok = false;
+    }
+    zip_fclose(zfile);
+
+    if (ok && entry.mtime >= 0)
+        out.setFileTime(QDateTime::fromSecsSinceEpoch(entry.mtime), QFileDevice::FileModificationTime);
+    out.close();
+    return ok;
+}
+
+void UnzipWorker::reportProgress(qint64 elapsedMs)
+{
+    const qint64 done = extractedBytes.load();
+    const int current = qMin(nextEntry.load(), entries.size()) - 1;
+    const QString content = current >= 0 ? entries.at(current).name : targetDir;
+
+    int progressbar = totalBytes > 0 ? static_cast<int>(done * 100 / totalBytes) : 0;
+    progressbar = qBound(0, progressbar - 1, 99);
+
+    int estimatedtime = 0;
+    if (done > 0 && elapsedMs > 0) {
+        const qint64 bytesPerSec = done * 1000 / elapsedMs;
+        if (bytesPerSec > 0)
+            estimatedtime = static_cast<int>((totalBytes - done) / bytesPerSec) + 1;
+    }
+
+    emit TransferHelper::instance()->transferContent(tr("Decompressing"), content, progressbar, estimatedtime);
 }
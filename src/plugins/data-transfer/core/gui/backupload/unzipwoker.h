@@ -1,10 +1,15 @@
 #ifndef UNZIPWORKER_H
 #define UNZIPWORKER_H
 
+#include <QHash>
 #include <QJsonObject>
+#include <QMutex>
+#include <QSet>
 #include <QString>
 #include <QThread>
-#include <QTimer>
+#include <QVector>
+
+#include <atomic>
 
 class UnzipWorker : public QThread
 {
@@ -16,31 +21,77 @@ public:
     void run() override;
 
     bool extract();
-    bool set();
-
-    static int getNumFiles(QString filepath);
 
     static bool isValid(QString filepath);
 
 private:
-    bool setUesrFile(QJsonObject jsonObj);
+    struct Entry
+    {
+        // Index into archives
+        int archive;
+        quint64 index;
+        QString name;
+        // Absolute path the entry is written to
+        QString target;
+        // Index into userFiles, -1 for entries staged in targetDir
+        int owner;
+        qint64 size;
+        qint64 mtime;
+    };
+
+    struct UserFile
+    {
+        // Path relative to the home directory, as listed in transfer.json
+        QString path;
+        // Final destination, already renamed if the original name is taken
+        QString target;
+        bool failed;
+    };
+
+private:
+    bool readManifest(struct zip *archive, const QJsonObject &backupFiles);
+    QHash<QString, QStringList> baseArchiveFiles(const QJsonObject &backupFiles) const;
+    bool readEntries();
+    void addEntry(struct zip *archive, int archiveIndex, quint64 index, QSet<QString> &dirs);
+    void extractEntries();
+    bool extractEntry(struct zip *archive, const Entry &entry, QByteArray &buffer);
+    void reportProgress(qint64 elapsedMs);
 
 private:
     QString filepath;
+    // The selected backup first, followed by the older backups an
+    // incremental backup refers to
+    QStringList archives;
+    // Staging dir for transfer.json, wallpaper and bookmarks
     QString targetDir;
-    QTimer *timer = nullptr;
 
-    //Number of decompression completed in the previous second
-    int previousTotal = 0;
+    // User files from transfer.json, keyed by their top level name in the archive
+    QVector<UserFile> userFiles;
+    QHash<QString, int> userFileIndex;
+    QMutex userFileMutex;
+
+    // Files the backup recorded as deleted since its base, never restored
+    QSet<QString> deletedFiles;
+
+    // User files are extracted straight to their final destinations
+    bool filesPlaced = false;
+
+    // File entries read from the central directory
+    QVector<Entry> entries;
+
+    // Uncompressed size of all entries
+    qint64 totalBytes = 0;
+
+    // Bytes written to disk so far, shared by the extracting threads
+    std::atomic<qint64> extractedBytes { 0 };
 
-    // Number of files that have been decompressed right now
-    int currentTotal = 0;
+    // Next entry to be picked up by an extracting thread
+    std::atomic<int> nextEntry { 0 };
 
-    // Number of files decompressed per second
-    int speed = -1;
+    std::atomic<int> failedEntries { 0 };
 
-    // Number of zip files
-    int count = 0;
+    // Run at low CPU and I/O priority unless full speed was requested
+    bool background = true;
 };
 
 #endif
@@ -13,8 +13,10 @@
 #include <QDropEvent>
 #include <QMimeData>
 #include <QUrl>
+#include <QCheckBox>
 
 #include <utils/transferhepler.h>
+#include <utils/optionsmanager.h>
 
 #pragma execution_character_set("utf-8")
 
@@ -53,6 +55,11 @@ void UploadFileWidget::initUI()
     tipLabel->setVisible(false);
     StyleHelper::setAutoFont(tipLabel, 12, QFont::Normal);
 
+    fullSpeedBox = new QCheckBox(tr("Restore at full speed, the computer may respond slowly"), this);
+    QHBoxLayout *fullSpeedLayout = new QHBoxLayout();
+    fullSpeedLayout->addWidget(fullSpeedBox);
+    fullSpeedLayout->setAlignment(Qt::AlignHCenter);
+
     QHBoxLayout *tipLayout = new QHBoxLayout();
     tipLayout->addWidget(tipLabel);
     tipLayout->setAlignment(Qt::AlignHCenter | Qt::AlignBottom);
@@ -76,6 +83,8 @@ void UploadFileWidget::initUI()
             nextButton->setText(tr("Retry"));
             return;
         }
+        OptionsManager::instance()->addUserOption(Options::kFullSpeed,
+                                                  { fullSpeedBox->isChecked() ? "true" : "false" });
         UnzipWorker *woker = new UnzipWorker(uploadFileFrame->getZipFilePath());
         woker->start();
         nextPage();
@@ -94,7 +103,9 @@ void UploadFileWidget::initUI()
     mainLayout->addWidget(titileLabel);
     mainLayout->addSpacing(20);
     mainLayout->addLayout(uploadLayout);
-    mainLayout->addSpacing(100);
+    mainLayout->addSpacing(70);
+    mainLayout->addLayout(fullSpeedLayout);
+    mainLayout->addSpacing(10);
     mainLayout->addLayout(tipLayout);
     mainLayout->addSpacing(5);
     mainLayout->addLayout(buttonLayout);
@@ -138,6 +149,7 @@ bool UploadFileWidget::checkBackupFile(const QString &filePath)
 
 void UploadFileWidget::clear()
 {
+    fullSpeedBox->setChecked(false);
     emit Initial();
 }
 
@@ -2,6 +2,7 @@
 #define UPLOADFILEWIDGET_H
 
 #include <QFrame>
+#include <QCheckBox>
 #include <QLabel>
 #include <QPushButton>
 
@@ -68,6 +69,7 @@ private:
     QPushButton *backButton { nullptr };
     QPushButton *nextButton { nullptr };
     QLabel *tipLabel { nullptr };
+    QCheckBox *fullSpeedBox { nullptr };
     UploadFileFrame *uploadFileFrame { nullptr };
 };
 
@@ -13,6 +13,7 @@
 #include <QLineEdit>
 #include <QStackedWidget>
 #include <QListView>
+#include <QCheckBox>
 
 #include <QStandardItemModel>
 #include <QStorageInfo>
@@ -57,6 +58,11 @@ void CreateBackupFileWidget::sendOptions()
     QStringList saveName;
     saveName << fileNameInput->getBackupFileName();
     OptionsManager::instance()->addUserOption(Options::kBackupFileName, saveName);
+
+    OptionsManager::instance()->addUserOption(Options::kBackupIncremental,
+                                              { incrementalBox->isChecked() ? "true" : "false" });
+    OptionsManager::instance()->addUserOption(Options::kFullSpeed,
+                                              { fullSpeedBox->isChecked() ? "true" : "false" });
     qInfo() << "backup file save path:" << savePath;
     qInfo() << "backup file name:" << saveName;
 }
@@ -69,6 +75,8 @@ void CreateBackupFileWidget::clear()
         model->setData(itemIndex, Qt::Unchecked, Qt::CheckStateRole);
     }
     fileNameInput->clear();
+    incrementalBox->setChecked(false);
+    fullSpeedBox->setChecked(false);
     determineButton->setEnabled(false);
 }
 
@@ -180,6 +188,16 @@ void CreateBackupFileWidget::initUI()
 
     diskListViewLayout->addWidget(diskListView);
 
+    incrementalBox = new QCheckBox(tr("Only back up changes since the last backup"), this);
+    QHBoxLayout *incrementalLayout = new QHBoxLayout();
+    incrementalLayout->addSpacing(130);
+    incrementalLayout->addWidget(incrementalBox);
+
+    fullSpeedBox = new QCheckBox(tr("Back up at full speed, the computer may respond slowly"), this);
+    QHBoxLayout *fullSpeedLayout = new QHBoxLayout();
+    fullSpeedLayout->addSpacing(130);
+    fullSpeedLayout->addWidget(fullSpeedBox);
+
     promptLabel = new QLabel(this);
 
     promptLabel->setText(
@@ -218,7 +236,11 @@ void CreateBackupFileWidget::initUI()
     mainLayout->addLayout(savePathLayout);
     mainLayout->addSpacing(10);
     mainLayout->addLayout(diskListViewLayout);
-    mainLayout->addSpacing(40);
+    mainLayout->addSpacing(15);
+    mainLayout->addLayout(incrementalLayout);
+    mainLayout->addSpacing(5);
+    mainLayout->addLayout(fullSpeedLayout);
+    mainLayout->addSpacing(10);
     mainLayout->addWidget(promptLabel);
     mainLayout->addSpacing(10);
     mainLayout->addLayout(buttonLayout);
@@ -10,6 +10,7 @@ class QStorageInfo;
 class QStandardItem;
 class QToolButton;
 class QPushButton;
+class QCheckBox;
 
 class NameLineEdit : public QLineEdit
 {
@@ -80,6 +81,8 @@ private:
     //    QLineEdit *fileNameInput{ nullptr };
     LineEditWidget *fileNameInput{ nullptr };
     QPushButton *determineButton{ nullptr };
+    QCheckBox *incrementalBox{ nullptr };
+    QCheckBox *fullSpeedBox{ nullptr };
     QList<QStorageInfo> deviceList;
 
     QMap<QStandardItem *, quint64> diskCapacity;
@@ -2,7 +2,9 @@
 #include <utils/transferhepler.h>
 
 #include "zipworker.h"
+#include <utils/backgroundpriority.h>
 #include "../win/drapwindowsdata.h"
+#include "../select/calculatefilesize.h"
 #include <common/commonutils.h>
 #include <QProcess>
 #include <QDebug>
@@ -15,12 +17,35 @@
 #include <JlCompress.h>
 #include <QDataStream>
 
-#define BUFFER_SIZE 8 * 1024
+#include <QFuture>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QQueue>
+#include <QSet>
+#include <QSysInfo>
+#include <QtConcurrent>
+
+#include <climits>
+#include <cmath>
+#include <zlib.h>
+
+inline constexpr char kBackupManifest[] { "backup-manifest.json" };
+
+// Read/write buffer used when a file is streamed into the archive
+inline constexpr int kBufferSize { 4 * 1024 * 1024 };
+// Files up to this size are deflated in memory on the thread pool
+inline constexpr qint64 kParallelMaxFileSize { 8 * 1024 * 1024 };
+// Minimum interval between two progress updates sent to the UI
+inline constexpr int kProgressIntervalMs { 250 };
+// Bytes sampled from the file head for the entropy test
+inline constexpr int kEntropySampleSize { 64 * 1024 };
+// Bits per byte above which the content is treated as already compressed
+inline constexpr double kIncompressibleEntropy { 7.5 };
+
 ZipWork::ZipWork(QObject *parent) : QThread(parent)
 {
     LOG << "zipwork start.";
 
-    maxNum = BUFFER_SIZE * 10240;
     // connect backup file process
     QObject::connect(this, &ZipWork::backupFileProcessSingal, TransferHelper::instance(),
                      &TransferHelper::zipTransferContent);
@@ -33,6 +58,8 @@ ZipWork::~ZipWork() { }
 
 void ZipWork::run()
 {
+    background = OptionsManager::instance()->getUserOption(Options::kFullSpeed).value(0) != "true";
+    BackgroundPriority priority(background);
     getUserDataPackagingFile();
 }
 
@@ -49,45 +76,146 @@ void ZipWork::getUserDataPackagingFile()
     backupFile(zipFilePathList, getBackupFilName());
 }
 
-int ZipWork::getPathFileNum(const QString &filePath)
+bool ZipWork::isIncompressible(const QString &filePath, const QByteArray &head)
 {
-    if (QFileInfo(filePath).isFile())
-        return 1;
-    int fileCount = 0;
-    QDir dir(filePath);
-    QFileInfoList entries = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs);
-
-    for (const QFileInfo &entry : entries) {
-        if (entry.isDir()) {
-            fileCount += getPathFileNum(entry.absoluteFilePath());
-        } else {
-            fileCount++;
-        }
+    static const QSet<QString> kCompressedSuffixes {
+        "jpg", "jpeg", "png", "gif", "webp", "heic", "mp3", "aac", "ogg", "flac", "m4a",
+        "mp4", "mkv", "avi", "mov", "wmv", "webm", "zip", "7z", "rar", "gz", "bz2", "xz",
+        "zst", "deb", "rpm", "apk", "jar", "iso", "docx", "xlsx", "pptx", "odt", "pdf"
+    };
+    if (kCompressedSuffixes.contains(QFileInfo(filePath).suffix().toLower()))
+        return true;
+
+    const int sampleSize = qMin(head.size(), kEntropySampleSize);
+    if (sampleSize < 4096)
+        return false;
+
+    quint32 histogram[256] = { 0 };
+    for (int i = 0; i < sampleSize; ++i)
+        histogram[static_cast<uchar>(head.at(i))]++;
+
+    double entropy = 0;
+    for (quint32 count : histogram) {
+        if (count == 0)
+            continue;
+        const double p = static_cast<double>(count) / sampleSize;
+        entropy -= p * std::log2(p);
+    }
+    return entropy > kIncompressibleEntropy;
+}
+
+ZipWork::CompressedEntry ZipWork::compressEntry(const BackupEntry &entry, bool background)
+{
+    // Runs on the shared pool, the priority is restored afterwards
+    BackgroundPriority priority(background);
+    CompressedEntry compressed { entry, QByteArray(), 0, Z_DEFLATED, false };
+
+    QFile sourceFile(entry.filePath);
+    if (!sourceFile.open(QIODevice::ReadOnly)) {
+        qCritical() << "Error reading source file:" << entry.filePath;
+        return compressed;
+    }
+    const QByteArray content = sourceFile.readAll();
+    sourceFile.close();
+
+    compressed.entry.size = content.size();
+    compressed.crc = static_cast<quint32>(
+            crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef *>(content.constData()),
+                  static_cast<uInt>(content.size())));
+
+    if (content.isEmpty() || isIncompressible(entry.filePath, content)) {
+        compressed.method = 0;
+        compressed.data = content;
+        compressed.ok = true;
+        return compressed;
     }
 
-    return fileCount;
+    // Raw deflate stream, the zip local header is written by QuaZip
+    z_stream stream {};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL,
+                     Z_DEFAULT_STRATEGY)
+        != Z_OK) {
+        qCritical() << "Error initializing deflate for:" << entry.filePath;
+        return compressed;
+    }
+    compressed.data.resize(static_cast<int>(deflateBound(&stream, static_cast<uLong>(content.size()))));
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(content.constData()));
+    stream.avail_in = static_cast<uInt>(content.size());
+    stream.next_out = reinterpret_cast<Bytef *>(compressed.data.data());
+    stream.avail_out = static_cast<uInt>(compressed.data.size());
+    int ret = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (ret != Z_STREAM_END) {
+        qCritical() << "Error compressing source file:" << entry.filePath;
+        return compressed;
+    }
+    compressed.data.resize(static_cast<int>(stream.total_out));
+
+    // Store the entry when deflate does not pay off
+    if (compressed.data.size() >= content.size()) {
+        compressed.method = 0;
+        compressed.data = content;
+    }
+    compressed.ok = true;
+    return compressed;
 }
 
-int ZipWork::getAllFileNum(const QStringList &fileList)
+void ZipWork::collectEntries(const QString &sourceFolder, const QString &relativeTo,
+                             QList<BackupEntry> &entries)
 {
-    int fileNum = 0;
+    QDir directory(sourceFolder);
+    QFileInfoList infos = directory.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot);
 
-    for (const QString &filePath : fileList) {
-        int curPathFileNum = getPathFileNum(filePath);
-        fileNum += curPathFileNum;
+    for (const QFileInfo &info : infos) {
+        if (info.isDir()) {
+            collectEntries(info.absoluteFilePath(), relativeTo, entries);
+        } else {
+            entries.append({ info.absoluteFilePath(),
+                             QDir(relativeTo).relativeFilePath(info.absoluteFilePath()), false,
+                             info.size(), info.lastModified().toSecsSinceEpoch() });
+        }
     }
-    return fileNum;
+
+    // If the current folder is empty, then create an empty directory
+    if (infos.isEmpty())
+        entries.append({ sourceFolder, QDir(relativeTo).relativeFilePath(sourceFolder) + "/", true, 0, 0 });
 }
 
-bool ZipWork::addFileToZip(const QString &filePath, const QString &relativeTo, QuaZip &zip,
-                           QElapsedTimer &timer)
+bool ZipWork::writeCompressedEntry(const CompressedEntry &compressed, QuaZip &zip)
 {
-    if (abort) {
-        zip.close();
-        QFile::remove(zipFile);
+    const QString &filePath = compressed.entry.filePath;
+    if (!compressed.ok) {
+        // backup file false
+        sendBackupFileFailMessage(filePath);
+        return false;
+    }
+
+    QuaZipFile destinationFile(&zip);
+    QuaZipNewInfo newInfo(compressed.entry.zipName, filePath);
+    newInfo.uncompressedSize = static_cast<ulong>(compressed.entry.size);
+    const int level = compressed.method == 0 ? 0 : Z_DEFAULT_COMPRESSION;
+    if (!destinationFile.open(QIODevice::WriteOnly, newInfo, nullptr, compressed.crc,
+                              compressed.method, level, true)) {
+        qCritical() << "Error writing to ZIP file for:" << filePath;
+        sendBackupFileFailMessage(filePath);
         return false;
     }
 
+    if (destinationFile.write(compressed.data) != compressed.data.size()) {
+        qCritical() << "Error writing to ZIP file for:" << filePath;
+        destinationFile.close();
+        sendBackupFileFailMessage(filePath);
+        return false;
+    }
+    destinationFile.close();
+
+    sendBackupFileProcess(filePath, compressed.entry.size);
+    return true;
+}
+
+bool ZipWork::addFileToZip(const BackupEntry &entry, QuaZip &zip)
+{
+    const QString &filePath = entry.filePath;
     QFile sourceFile(filePath);
     if (!sourceFile.open(QIODevice::ReadOnly)) {
         qCritical() << "Error reading source file:" << filePath;
@@ -96,10 +224,20 @@ bool ZipWork::addFileToZip(const QString &filePath, const QString &relativeTo, Q
         return false;
     }
 
+    // The head of the file decides whether it is worth deflating
+    QByteArray buffer(kBufferSize, Qt::Uninitialized);
+    qint64 bytesRead = sourceFile.read(buffer.data(), kBufferSize);
+    if (bytesRead == -1) {
+        qCritical() << "Error reading from source file:" << filePath;
+        sendBackupFileFailMessage(filePath);
+        return false;
+    }
+    const bool store = isIncompressible(filePath, QByteArray::fromRawData(buffer.constData(), static_cast<int>(bytesRead)));
+
     QuaZipFile destinationFile(&zip);
-    QString destinationFileName = QDir(relativeTo).relativeFilePath(filePath);
-    QuaZipNewInfo newInfo(destinationFileName, sourceFile.fileName());
-    if (!destinationFile.open(QIODevice::WriteOnly, newInfo)) {
+    QuaZipNewInfo newInfo(entry.zipName, filePath);
+    if (!destinationFile.open(QIODevice::WriteOnly, newInfo, nullptr, 0, store ? 0 : Z_DEFLATED,
+                              store ? 0 : Z_DEFAULT_COMPRESSION)) {
         qCritical() << "Error writing to ZIP file for:" << filePath;
         // backup file false
 
@@ -107,74 +245,108 @@ bool ZipWork::addFileToZip(const QString &filePath, const QString &relativeTo, Q
         return false;
     }
 
-    QDataStream in(&sourceFile);
-    char *buffer = reinterpret_cast<char *>(malloc(BUFFER_SIZE));
-    while (!in.atEnd()) {
-        memset(buffer, 0, BUFFER_SIZE);
-        qint64 bytesRead = in.readRawData(buffer, BUFFER_SIZE);
-        if (bytesRead == -1) {
-            free(buffer);
-            qCritical() << "Error reading from source file:" << filePath;
+    while (bytesRead > 0) {
+        if (abort)
+            return false;
+
+        qint64 bytesWritten = destinationFile.write(buffer.constData(), bytesRead);
+        if (bytesWritten == -1) {
+            qCritical() << "Error writing to ZIP file for:" << filePath;
             destinationFile.close();
             sourceFile.close();
             sendBackupFileFailMessage(filePath);
             return false;
         }
+        sendBackupFileProcess(filePath, bytesRead);
 
-        qint64 bytesWritten = destinationFile.write(buffer, bytesRead);
-        if (bytesWritten == -1) {
-            free(buffer);
-            qCritical() << "Error writing to ZIP file for:" << filePath;
+        bytesRead = sourceFile.read(buffer.data(), kBufferSize);
+        if (bytesRead == -1) {
+            qCritical() << "Error reading from source file:" << filePath;
             destinationFile.close();
             sourceFile.close();
             sendBackupFileFailMessage(filePath);
             return false;
         }
-
-        sendBackupFileProcess(filePath, timer, bytesRead);
     }
-    free(buffer);
     destinationFile.close();
     sourceFile.close();
 
     return true;
 }
 
-bool ZipWork::addFolderToZip(const QString &sourceFolder, const QString &relativeTo, QuaZip &zip,
-                             QElapsedTimer &timer)
+bool ZipWork::addDirToZip(const BackupEntry &entry, QuaZip &zip)
 {
-    QDir directory(sourceFolder);
-    QFileInfoList entries = directory.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot);
+    QuaZipFile dirZipFile(&zip);
+    QuaZipNewInfo newInfo(entry.zipName);
+    dirZipFile.open(QIODevice::WriteOnly, newInfo);
+    dirZipFile.close();
+    return true;
+}
 
-    for (QFileInfo entry : entries) {
-        if (entry.isDir()) {
-            if (!addFolderToZip(entry.absoluteFilePath(), relativeTo, zip, timer)) {
-                return false;
-            }
-        } else {
-            if (!addFileToZip(entry.absoluteFilePath(), relativeTo, zip, timer)) {
-                return false;
-            }
+QJsonObject ZipWork::sourceIdentity(const QStringList &entries)
+{
+    // Machine, user and selected roots; a base backup must come from the same source
+    QStringList roots;
+    for (const QString &entry : entries)
+        roots.append(QDir::cleanPath(QFileInfo(entry).absoluteFilePath()));
+    roots.sort(Qt::CaseInsensitive);
+
+    return QJsonObject { { "machine", QString::fromLatin1(QSysInfo::machineUniqueId()) },
+                         { "user", DrapWindowsData::instance()->getUserName() },
+                         { "roots", QJsonArray::fromStringList(roots) } };
+}
+
+QJsonObject ZipWork::loadBaseManifest(const QString &destinationZipFile, const QJsonObject &source,
+                                      QString *baseName)
+{
+    // The newest backup of the same source in the destination folder is the base
+    const QFileInfo destination(destinationZipFile);
+    const QFileInfoList candidates =
+            destination.dir().entryInfoList({ "*.zip" }, QDir::Files, QDir::Time);
+    for (const QFileInfo &candidate : candidates) {
+        if (candidate.absoluteFilePath() == destination.absoluteFilePath())
+            continue;
+
+        QuaZip zip(candidate.absoluteFilePath());
+        zip.setFileNameCodec("UTF-8");
+        if (!zip.open(QuaZip::mdUnzip) || !zip.setCurrentFile(kBackupManifest))
+            continue;
+        QuaZipFile file(&zip);
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+        const QJsonObject manifest = QJsonDocument::fromJson(file.readAll()).object();
+        file.close();
+
+        if (manifest.value("source").toObject() != source) {
+            DLOG << "skip base candidate of another source: " << candidate.fileName().toStdString();
+            continue;
+        }
+        if (manifest.value("files").isObject()) {
+            *baseName = candidate.fileName();
+            return manifest.value("files").toObject();
         }
     }
 
-    // If the current folder is empty, then create an empty directory
-    if (entries.isEmpty()) {
-        QuaZipFile dirZipFile(&zip);
-        QString dirFileName = QDir(relativeTo).relativeFilePath(sourceFolder) + "/";
-        QuaZipNewInfo newInfo(dirFileName);
-        dirZipFile.open(QIODevice::WriteOnly, newInfo);
-        dirZipFile.close();
-    }
+    WLOG << "no previous backup found, create a full backup";
+    return QJsonObject();
+}
 
-    return true;
+bool ZipWork::writeManifest(const QJsonObject &manifest, QuaZip &zip)
+{
+    QuaZipFile manifestFile(&zip);
+    if (!manifestFile.open(QIODevice::WriteOnly, QuaZipNewInfo(kBackupManifest))) {
+        qCritical() << "Error writing backup manifest";
+        return false;
+    }
+    manifestFile.write(QJsonDocument(manifest).toJson(QJsonDocument::Compact));
+    manifestFile.close();
+    return manifestFile.getZipError() == ZIP_OK;
 }
 
 bool ZipWork::backupFile(const QStringList &entries, const QString &destinationZipFile)
 {
     zipFile = destinationZipFile;
     QuaZip zip(destinationZipFile);
-    QElapsedTimer timer;
     zip.setFileNameCodec("UTF-8");
     if (!zip.open(QuaZip::mdCreate)) {
         qCritical("Error creating the ZIP file.");
@@ -183,22 +355,140 @@ bool ZipWork::backupFile(const QStringList &entries, const QString &destinationZ
         return false;
     }
 
+    // The trees were already sized for the selection page. Their cached totals
+    // reserve the entry list and, when every tree is cached, give the progress total.
+    // The walk below still lists every file: the archive needs the names and the
+    // manifest needs fresh sizes and mtimes.
+    quint64 expectedCount = 0;
+    quint64 expectedSize = 0;
+    bool allCached = true;
+    for (const QString &entry : entries) {
+        QFileInfo fileInfo(entry);
+        PathSize cached;
+        if (fileInfo.isFile()) {
+            expectedCount++;
+            expectedSize += static_cast<quint64>(fileInfo.size());
+        } else if (CalculateFileSizeThreadPool::instance()->cachedPathSize(entry, &cached)) {
+            expectedCount += cached.fileCount;
+            expectedSize += cached.size;
+        } else {
+            allCached = false;
+        }
+    }
+    if (allCached && expectedSize > 0)
+        allFileSize = expectedSize;
+
+    QList<BackupEntry> backupEntries;
+    backupEntries.reserve(static_cast<int>(qMin<quint64>(expectedCount, INT_MAX)));
     for (QString entry : entries) {
 
         QFileInfo fileInfo(entry);
         if (fileInfo.isDir()) {
             QDir parent = QDir(entry);
             parent.cdUp();
-            if (!addFolderToZip(entry, QDir(parent).absolutePath(), zip, timer)) {
-                return false;
-            }
+            collectEntries(entry, QDir(parent).absolutePath(), backupEntries);
         } else if (fileInfo.isFile()) {
-            if (!addFileToZip(entry, fileInfo.absolutePath(), zip, timer)) {
-                return false;
-            }
+            backupEntries.append({ entry, fileInfo.fileName(), false, fileInfo.size(),
+                                   fileInfo.lastModified().toSecsSinceEpoch() });
         }
     }
 
+    // Every backup records the state of all its files. An incremental backup
+    // only stores what changed since the latest backup in the same folder and
+    // points the unchanged files to the archive that holds them.
+    const bool incremental =
+            OptionsManager::instance()->getUserOption(Options::kBackupIncremental).value(0) == "true";
+    const QString archiveName = QFileInfo(destinationZipFile).fileName();
+    const QJsonObject source = sourceIdentity(entries);
+    QString baseName;
+    const QJsonObject baseFiles =
+            incremental ? loadBaseManifest(destinationZipFile, source, &baseName) : QJsonObject();
+
+    QJsonObject manifestFiles;
+    QList<BackupEntry> changedEntries;
+    quint64 changedSize = 0;
+    for (const BackupEntry &entry : backupEntries) {
+        if (!entry.isDir) {
+            const QJsonObject base = baseFiles.value(entry.zipName).toObject();
+            const bool unchanged = !base.isEmpty()
+                    && static_cast<qint64>(base.value("size").toDouble()) == entry.size
+                    && static_cast<qint64>(base.value("mtime").toDouble()) == entry.mtime;
+            manifestFiles.insert(entry.zipName,
+                                 QJsonObject { { "size", static_cast<double>(entry.size) },
+                                               { "mtime", static_cast<double>(entry.mtime) },
+                                               { "archive", unchanged ? base.value("archive").toString() : archiveName } });
+            if (unchanged)
+                continue;
+            changedSize += static_cast<quint64>(entry.size);
+        }
+        changedEntries.append(entry);
+    }
+    QJsonArray deletedFiles;
+    for (auto it = baseFiles.constBegin(); it != baseFiles.constEnd(); ++it) {
+        if (!manifestFiles.contains(it.key()))
+            deletedFiles.append(it.key());
+    }
+    if (!baseName.isEmpty()) {
+        allFileSize = changedSize;
+        LOG << "incremental backup based on " << baseName.toStdString() << ", changed:"
+            << changedEntries.size() << "/" << backupEntries.size() << " deleted:" << deletedFiles.size();
+    }
+
+    timer.start();
+    progressTimer.start();
+
+    // Small files are deflated in parallel into independent streams and appended
+    // to the archive in their original order; large files are streamed in place.
+    QQueue<QFuture<CompressedEntry>> pending;
+    const int maxPending = qMax(2, QThreadPool::globalInstance()->maxThreadCount() * 2);
+    auto writeNext = [&]() {
+        return writeCompressedEntry(pending.dequeue().result(), zip);
+    };
+
+    bool ok = true;
+    for (const BackupEntry &entry : changedEntries) {
+        if (abort)
+            break;
+
+        if (!entry.isDir && entry.size <= kParallelMaxFileSize) {
+            pending.enqueue(QtConcurrent::run(&ZipWork::compressEntry, entry, background));
+            if (pending.size() >= maxPending && !(ok = writeNext()))
+                break;
+            continue;
+        }
+
+        while (ok && !pending.isEmpty())
+            ok = writeNext();
+        if (!ok)
+            break;
+
+        ok = entry.isDir ? addDirToZip(entry, zip) : addFileToZip(entry, zip);
+        if (!ok)
+            break;
+    }
+    while (ok && !abort && !pending.isEmpty())
+        ok = writeNext();
+    for (QFuture<CompressedEntry> &future : pending)
+        future.waitForFinished();
+
+    if (abort) {
+        zip.close();
+        QFile::remove(zipFile);
+        return false;
+    }
+    if (!ok)
+        return false;
+
+    const QJsonObject manifest { { "version", 2 },
+                                 { "source", source },
+                                 { "base", baseName },
+                                 { "files", manifestFiles },
+                                 { "deleted", deletedFiles } };
+    if (!writeManifest(manifest, zip)) {
+        sendBackupFileFailMessage(destinationZipFile);
+        return false;
+    }
+
     zip.close();
 
     if (zip.getZipError() != UNZ_OK) {
@@ -209,46 +499,30 @@ bool ZipWork::backupFile(const QStringList &entries, const QString &destinationZ
         return false;
     }
 
+    LOG << "backup file done, files:" << changedEntries.size() << " bytes:" << zipFileSize
+        << " cost(ms):" << timer.elapsed();
     // backup file true
     emit backupFileProcessSingal(QString(tr("Back up file done")), 100, 0);
     return true;
 }
 
-void ZipWork::sendBackupFileProcess(const QString &filePath, QElapsedTimer &timer, int size)
+void ZipWork::sendBackupFileProcess(const QString &filePath, qint64 size)
 {
-    zipFileSize += size;
-    num += size;
-    double progress = (static_cast<double>(zipFileSize) / static_cast<double>(allFileSize)) * 100;
-    if (!timer.isValid()) {
-        timer.start();
-    } else {
-        quint64 tempTime = 0;
-        if (firstFlag) {
-            tempTime = BUFFER_SIZE * 5;
-        } else {
-            tempTime = maxNum;
-        }
-        LOG << "num:" << num << " tempTime:" << tempTime;
-        // If the timer is started, the elapsed time is calculated and the timer is restarted
-        if (num >= tempTime) {
-            firstFlag = false;
-            qint64 elapsed = timer.restart();
-            if (allFileSize <= zipFileSize) {
-                needTime = static_cast<int>(elapsed * (0 / num)) / 1000;
-                LOG << "needtime:" << needTime << "(allFileSize - zipFileSize):" << 0
-                    << "zipFileSize:" << zipFileSize << " num:" << num << " elapsed:" << elapsed;
-            } else {
-                needTime = static_cast<int>(elapsed * ((allFileSize - zipFileSize) / num)) / 1000;
-                LOG << "needtime:" << needTime
-                    << "(allFileSize - zipFileSize)/num:" << (allFileSize - zipFileSize) / num
-                    << " zipFileSize:" << zipFileSize << " num:" << num << "elapsed:" << elapsed;
-            }
-            num = 0;
-        }
+    zipFileSize += static_cast<quint64>(size);
+    if (progressTimer.elapsed() < kProgressIntervalMs)
+        return;
+    progressTimer.restart();
+
+    const qint64 elapsed = timer.elapsed();
+    if (elapsed > 0 && zipFileSize > 0) {
+        const double remain = allFileSize > zipFileSize ? static_cast<double>(allFileSize - zipFileSize) : 0;
+        needTime = static_cast<int>(remain * elapsed / zipFileSize / 1000);
     }
 
+    double progress = (static_cast<double>(zipFileSize) / static_cast<double>(allFileSize)) * 100;
     needTime = std::max(std::min(needTime, 3600), 1);
-    int iprogress = std::max(std::min((int)progress, 100), 0);
+    // 100 is reserved for the final "done" notification
+    int iprogress = std::max(std::min((int)progress, 99), 0);
 
     emit backupFileProcessSingal(filePath, iprogress, needTime);
 }
@@ -1,9 +1,11 @@
 ﻿#ifndef ZIPWORKER_H
 #define ZIPWORKER_H
 
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QJsonObject>
 #include <QThread>
 
-class QElapsedTimer;
 class QuaZip;
 class ZipWork : public QThread
 {
@@ -14,19 +16,42 @@ public:
 
     void run() override;
 
+    struct BackupEntry
+    {
+        QString filePath;
+        QString zipName;
+        bool isDir;
+        qint64 size;
+        qint64 mtime;
+    };
+
+    struct CompressedEntry
+    {
+        BackupEntry entry;
+        QByteArray data;
+        quint32 crc;
+        int method;
+        bool ok;
+    };
+
+    static CompressedEntry compressEntry(const BackupEntry &entry, bool background);
+    static bool isIncompressible(const QString &filePath, const QByteArray &head);
+
 private:
     void getUserDataPackagingFile();
 
-    int getPathFileNum(const QString &filePath);
-    int getAllFileNum(const QStringList &fileList);
-
-    bool addFileToZip(const QString &filePath, const QString &relativeTo, QuaZip &zip,
-                      QElapsedTimer &timer);
-    bool addFolderToZip(const QString &sourceFolder, const QString &relativeTo, QuaZip &zip,
-                        QElapsedTimer &timer);
+    void collectEntries(const QString &sourceFolder, const QString &relativeTo,
+                        QList<BackupEntry> &entries);
+    bool addFileToZip(const BackupEntry &entry, QuaZip &zip);
+    bool addDirToZip(const BackupEntry &entry, QuaZip &zip);
+    bool writeCompressedEntry(const CompressedEntry &compressed, QuaZip &zip);
+    static QJsonObject sourceIdentity(const QStringList &entries);
+    QJsonObject loadBaseManifest(const QString &destinationZipFile, const QJsonObject &source,
+                                 QString *baseName);
+    bool writeManifest(const QJsonObject &manifest, QuaZip &zip);
     bool backupFile(const QStringList &sourceFilePath, const QString &zipFileSave);
 
-    void sendBackupFileProcess(const QString &filePath, QElapsedTimer &timer,int size);
+    void sendBackupFileProcess(const QString &filePath, qint64 size);
 
     QString getBackupFilName();
 
@@ -39,12 +64,15 @@ public slots:
 private:
     quint64 allFileSize{ 0 };
     quint64 zipFileSize{ 0 };
-    int lastZipFileNum{ 0 };
     int needTime{ 3600 };
     bool abort{ false };
-    quint64 num{ 0 };
-    quint64 maxNum{ 0 };
     QString zipFile;
-    bool firstFlag {true};
+    // Run at low CPU and I/O priority unless full speed was requested
+    bool background{ true };
+
+    // Whole backup duration, used for the throughput estimate
+    QElapsedTimer timer;
+    // Time since the last progress update sent to the UI
+    QElapsedTimer progressTimer;
 };
 #endif
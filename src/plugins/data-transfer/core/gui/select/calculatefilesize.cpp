@@ -14,6 +14,14 @@
 #include <QCoreApplication>
 #include <math.h>
 #include <QMutex>
+#include <QDirIterator>
+#include <QSet>
+
+#ifdef Q_OS_WIN
+#    include <windows.h>
+#else
+#    include <sys/stat.h>
+#endif
 
 QString fromByteToQstring(quint64 bytes)
 {
@@ -72,9 +80,17 @@ CalculateFileSizeTask::~CalculateFileSizeTask() { }
 
 void CalculateFileSizeTask::run()
 {
-    fileSize = calculate(filePath);
+    CalculateFileSizeThreadPool *pool = CalculateFileSizeThreadPool::instance();
+    PathSize result;
+    if (!pool->cachedPathSize(filePath, &result)) {
+        QHash<QString, qint64> dirMtimes;
+        result = calculate(filePath, &abort, &dirMtimes);
+        if (abort)
+            return;
+        pool->insertCache(filePath, result, dirMtimes);
+    }
     QMetaObject::invokeMethod(calculatePool, "sendFileSizeSlots", Qt::QueuedConnection,
-                              Q_ARG(quint64, fileSize), Q_ARG(QString, filePath));
+                              Q_ARG(quint64, result.size), Q_ARG(QString, filePath));
 }
 
 void CalculateFileSizeTask::abortTask()
@@ -82,25 +98,72 @@ void CalculateFileSizeTask::abortTask()
     abort = true;
 }
 
-qlonglong CalculateFileSizeTask::calculate(const QString &path)
+// Files below this size are not checked for hardlinks. Counting such a file
+// twice barely changes the total, and the check opens a handle per file.
+static constexpr qint64 kHardlinkMinSize = 1024 * 1024;
+
+// Returns true if the file has more than one link and one of them was seen already
+static bool seenHardlink(const QString &path, QSet<QPair<quint64, quint64>> *seen)
 {
-    if (abort) {
-        return 0;
-    }
+    QPair<quint64, quint64> id;
+#ifdef Q_OS_WIN
+    HANDLE handle = CreateFileW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(path).utf16()),
+                                0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT,
+                                nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    BY_HANDLE_FILE_INFORMATION info;
+    const bool ok = GetFileInformationByHandle(handle, &info);
+    CloseHandle(handle);
+    if (!ok || info.nNumberOfLinks <= 1)
+        return false;
+    id = qMakePair(static_cast<quint64>(info.dwVolumeSerialNumber),
+                   (static_cast<quint64>(info.nFileIndexHigh) << 32) | info.nFileIndexLow);
+#else
+    struct stat st;
+    if (::lstat(QFile::encodeName(path).constData(), &st) != 0 || st.st_nlink <= 1)
+        return false;
+    id = qMakePair(static_cast<quint64>(st.st_dev), static_cast<quint64>(st.st_ino));
+#endif
+    if (seen->contains(id))
+        return true;
+    seen->insert(id);
+    return false;
+}
 
-    QDir directory(path);
-    directory.setFilter(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
-    QFileInfoList fileList = directory.entryInfoList();
-    qlonglong tempSize = 0;
-    for (const QFileInfo &fileInfo : fileList) {
+PathSize CalculateFileSizeTask::calculate(const QString &path, const bool *abort,
+                                          QHash<QString, qint64> *dirMtimes)
+{
+    // Symlinks and junctions are neither counted nor followed, so link
+    // loops cannot recurse forever and linked trees are not counted twice.
+    // Hardlinked files of at least kHardlinkMinSize are counted once.
+    PathSize result;
+    QSet<QPair<quint64, quint64>> hardlinks;
+    if (dirMtimes)
+        dirMtimes->insert(path, QFileInfo(path).lastModified().toMSecsSinceEpoch());
+
+    QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        if (abort && *abort)
+            break;
+        it.next();
+        const QFileInfo fileInfo = it.fileInfo();
+        if (fileInfo.isSymLink())
+            continue;
         if (fileInfo.isDir()) {
-            tempSize += calculate(fileInfo.absoluteFilePath());
-        } else {
-            tempSize += fileInfo.size();
+            if (dirMtimes)
+                dirMtimes->insert(fileInfo.absoluteFilePath(), fileInfo.lastModified().toMSecsSinceEpoch());
+            continue;
         }
+        if (fileInfo.size() >= kHardlinkMinSize && seenHardlink(fileInfo.absoluteFilePath(), &hardlinks))
+            continue;
+        result.size += static_cast<quint64>(fileInfo.size());
+        result.fileCount++;
     }
 
-    return tempSize;
+    return result;
 }
 
 CalculateFileSizeThreadPool *CalculateFileSizeThreadPool::instance()
@@ -128,6 +191,7 @@ void CalculateFileSizeThreadPool::work(const QList<QString> &list)
         if (fileInfo.isFile()) {
             continue;
         } else if (fileInfo.isDir()) {
+            // the task checks the cache first, validating it stats every directory
             CalculateFileSizeTask *task = new CalculateFileSizeTask(this, path);
             workList.push_back(task);
             threadPool->start(task);
@@ -153,6 +217,40 @@ QMap<QString, FileInfo> *CalculateFileSizeThreadPool::getFileMap()
     return fileMap;
 }
 
+bool CalculateFileSizeThreadPool::cachedPathSize(const QString &path, PathSize *result)
+{
+    CachedTree tree;
+    {
+        QMutexLocker locker(&cacheMutex);
+        auto it = sizeCache.constFind(path);
+        if (it == sizeCache.constEnd())
+            return false;
+        tree = it.value();
+    }
+
+    // Adding, removing or renaming an entry anywhere in the tree changes the
+    // mtime of its directory; stat'ing the directories is far cheaper than a walk.
+    for (auto it = tree.dirMtimes.constBegin(); it != tree.dirMtimes.constEnd(); ++it) {
+        const QFileInfo info(it.key());
+        if (!info.exists() || info.lastModified().toMSecsSinceEpoch() != it.value()) {
+            LOG << "file size cache invalidated:" << path.toStdString();
+            QMutexLocker locker(&cacheMutex);
+            sizeCache.remove(path);
+            return false;
+        }
+    }
+
+    *result = tree.size;
+    return true;
+}
+
+void CalculateFileSizeThreadPool::insertCache(const QString &path, const PathSize &result,
+                                              const QHash<QString, qint64> &dirMtimes)
+{
+    QMutexLocker locker(&cacheMutex);
+    sizeCache.insert(path, { result, dirMtimes });
+}
+
 void CalculateFileSizeThreadPool::sendFileSizeSlots(quint64 fileSize, const QString &path)
 {
     if (!fileMap->contains(path))
@@ -1,7 +1,9 @@
 ﻿#ifndef CALCULATEFILESIZE_H
 #define CALCULATEFILESIZE_H
 
+#include <QHash>
 #include <QModelIndex>
+#include <QMutex>
 #include <QObject>
 #include <QRunnable>
 #include <QThread>
@@ -10,7 +12,6 @@ class QListView;
 class QThreadPool;
 class QTimer;
 class QStandardItem;
-class QMutex;
 struct FileInfo
 {
     quint64 size;
@@ -20,6 +21,12 @@ struct FileInfo
     QStandardItem *siderbarItem;
 };
 
+struct PathSize
+{
+    quint64 size { 0 };
+    quint64 fileCount { 0 };
+};
+
 QString fromByteToQstring(quint64 bytes);
 quint64 fromQstringToByte(QString sizeString);
 
@@ -31,10 +38,12 @@ public:
     void run() override;
     void abortTask();
 
+    // dirMtimes receives the mtime of every directory walked, to validate the result later
+    static PathSize calculate(const QString &path, const bool *abort = nullptr,
+                              QHash<QString, qint64> *dirMtimes = nullptr);
+
 private:
-    qlonglong calculate(const QString &path);
     QString filePath;
-    qlonglong fileSize{ 0 };
     QObject *calculatePool{ nullptr };
     bool abort{ false };
 };
@@ -53,6 +62,11 @@ public:
 
     QMap<QString, FileInfo> *getFileMap();
 
+    // A cached result is only returned while no directory of the tree changed
+    bool cachedPathSize(const QString &path, PathSize *result);
+    void insertCache(const QString &path, const PathSize &result,
+                     const QHash<QString, qint64> &dirMtimes);
+
 public slots:
     void sendFileSizeSlots(quint64 fileSize, const QString &path);
     void addFileSlots(const QList<QString> &list);
@@ -66,6 +80,14 @@ private:
     QThreadPool *threadPool;
     QList<CalculateFileSizeTask *> workList;
 
+    struct CachedTree
+    {
+        PathSize size;
+        QHash<QString, qint64> dirMtimes;
+    };
+    QHash<QString, CachedTree> sizeCache;
+    QMutex cacheMutex;
+
 public:
     QMap<QString, FileInfo> *fileMap;
 };
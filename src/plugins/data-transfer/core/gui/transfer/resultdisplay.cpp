@@ -65,6 +65,8 @@ void ResultDisplayWidget::initUI()
 
     connect(TransferHelper::instance(), &TransferHelper::addResult, this,
             &ResultDisplayWidget::addResult);
+    connect(TransferHelper::instance(), &TransferHelper::addResults, this,
+            &ResultDisplayWidget::addResults);
 #ifdef linux
     connect(TransferHelper::instance(), &TransferHelper::transferFinished, this, [this] {
         TransferHelper::instance()->sendMessage("add_result", processText);
@@ -111,6 +113,18 @@ void ResultDisplayWidget::addResult(QString name, bool success, QString reason)
     processText.append(name + " " + res + " " + reason + ";");
 }
 
+void ResultDisplayWidget::addResults(const QStringList &names, bool success, const QString &reason)
+{
+    if (!success && !names.isEmpty())
+        setStatus(false);
+
+    QString res = success ? "true" : "false";
+    for (const QString &name : names) {
+        resultWindow->updateContent(name, reason, success);
+        processText.append(name + " " + res + " " + reason + ";");
+    }
+}
+
 void ResultDisplayWidget::clear()
 {
     resultWindow->clear();
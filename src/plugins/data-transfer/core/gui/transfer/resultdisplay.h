@@ -28,6 +28,7 @@ public:
 public slots:
     void themeChanged(int theme);
     void addResult(QString name, bool success, QString reason);
+    void addResults(const QStringList &names, bool success, const QString &reason);
     void clear();
     void setStatus(bool success);
 
@@ -0,0 +1,178 @@
+#include "backgroundpriority.h"
+
+#include <co/log.h>
+
+#include <QFile>
+#include <QThread>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <mutex>
+
+#ifdef WIN32
+#    include <windows.h>
+#else
+#    include <sys/resource.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+
+// ioprio_set(2) has no glibc wrapper
+inline constexpr int kIoPrioWhoProcess { 1 };
+inline constexpr int kIoPrioClassShift { 13 };
+inline constexpr int kIoPrioClassBestEffort { 2 };
+// Lowest level of the best-effort class. The idle class is not used, it can
+// starve the job completely while the desktop keeps the disk busy.
+inline constexpr int kIoPrioLowest { 7 };
+inline constexpr int kBackgroundNice { 10 };
+#endif
+
+// Interval between two reads of the I/O pressure
+inline constexpr int kPressureIntervalMs { 500 };
+// Samples averaged into the baseline at the start of a job, while it runs alone
+inline constexpr int kBaselineSamples { 4 };
+// A gap this long between samples means a new job, the baseline is measured again
+inline constexpr int kBaselineResetMs { 10 * kPressureIntervalMs };
+// Percentage of stalled time above the baseline at which the job backs off
+inline constexpr double kPressureThreshold { 20.0 };
+inline constexpr int kMaxBackoffMs { 100 };
+
+static std::atomic<int> backoffMs { 0 };
+
+#ifndef WIN32
+// Reads the cumulative stall time in microseconds of the "some" line
+static qint64 ioStallTotal()
+{
+    QFile pressure("/proc/pressure/io");
+    if (!pressure.open(QIODevice::ReadOnly))
+        return -1;
+    // some avg10=1.23 avg60=0.50 avg300=0.10 total=12345
+    const QByteArray line = pressure.readLine().trimmed();
+    const int start = line.indexOf("total=");
+    if (!line.startsWith("some") || start < 0)
+        return -1;
+    bool ok = false;
+    const qint64 total = line.mid(start + 6).toLongLong(&ok);
+    return ok ? total : -1;
+}
+
+// PSI is system wide and also counts the job's own stalls, so only the
+// pressure above what the job causes by itself is taken as other tasks
+// waiting. Returns the backoff in ms.
+static int sampleBackoff(qint64 now)
+{
+    static qint64 lastTotal = -1;
+    static qint64 lastAt = 0;
+    static double baseline = 0;
+    static int samples = 0;
+
+    const qint64 total = ioStallTotal();
+    if (total < 0)
+        return 0;
+
+    const qint64 elapsed = now - lastAt;
+    if (lastTotal < 0 || total < lastTotal || elapsed > kBaselineResetMs) {
+        lastTotal = total;
+        lastAt = now;
+        baseline = 0;
+        samples = 0;
+        return 0;
+    }
+    if (elapsed <= 0)
+        return backoffMs.load();
+
+    // stalled us per elapsed ms, as a percentage
+    const double some = static_cast<double>(total - lastTotal) / (10.0 * static_cast<double>(elapsed));
+    lastTotal = total;
+    lastAt = now;
+
+    if (samples < kBaselineSamples) {
+        baseline = (baseline * samples + some) / (samples + 1);
+        ++samples;
+        return 0;
+    }
+
+    const double extra = some - baseline;
+    // Follow the job's own load: down at once, up slowly and only while
+    // nobody else is pushing the pressure up
+    if (some < baseline)
+        baseline = some;
+    else if (extra <= kPressureThreshold)
+        baseline += (some - baseline) / 8;
+
+    return extra > kPressureThreshold ? qMin(kMaxBackoffMs, static_cast<int>(extra)) : 0;
+}
+#endif
+
+static qint64 steadyMs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+BackgroundPriority::BackgroundPriority(bool enabled)
+{
+    if (!enabled)
+        return;
+
+#ifdef WIN32
+    // Lowers CPU, I/O and memory priority of the thread together
+    lowered = SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#else
+    const pid_t tid = static_cast<pid_t>(::syscall(SYS_gettid));
+    errno = 0;
+    oldNice = ::getpriority(PRIO_PROCESS, static_cast<id_t>(tid));
+    if (errno != 0)
+        oldNice = 0;
+    oldIoPriority = static_cast<int>(::syscall(SYS_ioprio_get, kIoPrioWhoProcess, tid));
+
+    const int ioPriority = (kIoPrioClassBestEffort << kIoPrioClassShift) | kIoPrioLowest;
+    const bool ioLowered = ::syscall(SYS_ioprio_set, kIoPrioWhoProcess, tid, ioPriority) == 0;
+    const bool cpuLowered = ::setpriority(PRIO_PROCESS, static_cast<id_t>(tid), kBackgroundNice) == 0;
+    lowered = ioLowered || cpuLowered;
+#endif
+    if (!lowered)
+        WLOG << "failed to lower the thread priority";
+}
+
+BackgroundPriority::~BackgroundPriority()
+{
+    if (!lowered)
+        return;
+
+#ifdef WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+#else
+    // Raising the nice value back needs CAP_SYS_NICE, threads of a private
+    // pool end right after anyway
+    const pid_t tid = static_cast<pid_t>(::syscall(SYS_gettid));
+    if (oldIoPriority >= 0)
+        ::syscall(SYS_ioprio_set, kIoPrioWhoProcess, tid, oldIoPriority);
+    if (::setpriority(PRIO_PROCESS, static_cast<id_t>(tid), oldNice) != 0)
+        DLOG << "thread keeps nice " << kBackgroundNice << ", restoring needs CAP_SYS_NICE";
+#endif
+}
+
+void BackgroundPriority::throttle()
+{
+#ifndef WIN32
+    // One thread samples /proc/pressure/io (PSI) per interval, every thread
+    // then sleeps the resulting backoff at most once per interval.
+    static std::atomic<qint64> nextSample { 0 };
+    static std::mutex sampleLock;
+    thread_local qint64 nextBackoff = 0;
+
+    const qint64 now = steadyMs();
+    qint64 expected = nextSample.load();
+    if (now >= expected && nextSample.compare_exchange_strong(expected, now + kPressureIntervalMs)) {
+        std::lock_guard<std::mutex> lock(sampleLock);
+        backoffMs = sampleBackoff(now);
+    }
+
+    const int backoff = backoffMs.load();
+    if (backoff > 0 && now >= nextBackoff) {
+        nextBackoff = now + kPressureIntervalMs;
+        QThread::msleep(static_cast<unsigned long>(backoff));
+    }
+#endif
+}
@@ -0,0 +1,25 @@
+#ifndef BACKGROUNDPRIORITY_H
+#define BACKGROUNDPRIORITY_H
+
+// Runs the current thread at a low CPU and I/O priority while it is alive,
+// so a backup or restore does not make the desktop sluggish.
+// On Linux the nice value can only be raised back with CAP_SYS_NICE, use it
+// on threads that end with the job, not on a shared pool.
+class BackgroundPriority
+{
+public:
+    explicit BackgroundPriority(bool enabled = true);
+    ~BackgroundPriority();
+
+    // Backs off for a moment while other tasks are stalled on I/O.
+    // Linux only, it needs PSI. On Windows the background mode already
+    // serves other I/O first, so this does nothing there.
+    static void throttle();
+
+private:
+    bool lowered { false };
+    int oldNice { 0 };
+    int oldIoPriority { 0 };
+};
+
+#endif
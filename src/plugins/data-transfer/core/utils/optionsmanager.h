@@ -39,6 +39,8 @@ inline constexpr char KWallpaperPath[]{ "wallpaperPath" };
 inline constexpr char KBookmarksJsonPath[]{ "bookmarksJsonPath" };
 inline constexpr char KBackupFileSize[] {"backupFileSize"};
 inline constexpr char kTransferFileList[]{"transferFileList"};
+inline constexpr char kBackupIncremental[]{"backupIncremental"};
+inline constexpr char kFullSpeed[]{"fullSpeed"};
 } // namespace Options
 
 namespace TransferMethod {
@@ -9,10 +9,165 @@
 #include <QDBusConnection>
 #include <QDBusInterface>
 #include <QDBusArgument>
+#include <QDBusPendingReply>
+#include <QDBusPendingCallWatcher>
 #include <QGuiApplication>
 #include <QScreen>
 #include <QDir>
 #include <QJsonDocument>
+#include <QSet>
+#include <QtConcurrent>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#ifndef RENAME_NOREPLACE
+#    define RENAME_NOREPLACE (1 << 0)
+#endif
+
+// Highest "(n)" suffix tried before giving up on a name conflict
+inline constexpr int kMaxNameIndex { 10000 };
+inline constexpr size_t kCopyBufferSize { 4 * 1024 * 1024 };
+
+inline constexpr char kLastoreService[] { "com.deepin.lastore" };
+
+// rename() that fails with EEXIST instead of replacing the target
+static int renameNoReplace(const char *src, const char *dst)
+{
+#ifdef SYS_renameat2
+    int ret = static_cast<int>(::syscall(SYS_renameat2, AT_FDCWD, src, AT_FDCWD, dst, RENAME_NOREPLACE));
+    if (ret == 0 || (errno != ENOSYS && errno != EINVAL))
+        return ret;
+#endif
+    // Kernel or filesystem without RENAME_NOREPLACE
+    struct stat st;
+    if (::lstat(dst, &st) == 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    return ::rename(src, dst);
+}
+
+static bool copyFileData(int in, int out, off_t size)
+{
+    bool useRange = true;
+    std::vector<char> buffer;
+    while (size > 0) {
+        ssize_t n = -1;
+#ifdef SYS_copy_file_range
+        if (useRange) {
+            // In-kernel copy, filesystems with reflink support share the extents
+            n = ::syscall(SYS_copy_file_range, in, nullptr, out, nullptr, static_cast<size_t>(size), 0);
+            if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                useRange = false;
+                continue;
+            }
+        } else
+#endif
+        {
+            if (buffer.empty())
+                buffer.resize(kCopyBufferSize);
+            n = ::read(in, buffer.data(), buffer.size());
+            for (ssize_t written = 0; n > 0 && written < n;) {
+                ssize_t w = ::write(out, buffer.data() + written, static_cast<size_t>(n - written));
+                if (w < 0)
+                    return false;
+                written += w;
+            }
+        }
+        if (n < 0)
+            return false;
+        if (n == 0)
+            break;
+        size -= n;
+    }
+    return true;
+}
+
+// Copies src to a not yet existing dst, errno is EEXIST if dst is taken.
+// With removeSource the source is deleted once the copy completed.
+static bool copyPath(const QByteArray &src, const QByteArray &dst, bool removeSource)
+{
+    struct stat st;
+    if (::lstat(src.constData(), &st) != 0)
+        return false;
+
+    bool ok = true;
+    if (S_ISDIR(st.st_mode)) {
+        if (::mkdir(dst.constData(), st.st_mode & 07777) != 0)
+            return false;
+        DIR *dir = ::opendir(src.constData());
+        if (!dir)
+            return false;
+        while (struct dirent *entry = ::readdir(dir)) {
+            if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+                continue;
+            if (!copyPath(src + "/" + entry->d_name, dst + "/" + entry->d_name, false)) {
+                ok = false;
+                break;
+            }
+        }
+        ::closedir(dir);
+        if (ok) {
+            // after the children, creating them changed the mtime
+            struct timespec times[2] = { st.st_atim, st.st_mtim };
+            ::utimensat(AT_FDCWD, dst.constData(), times, 0);
+        } else {
+            QDir(QFile::decodeName(dst)).removeRecursively();
+        }
+    } else if (S_ISLNK(st.st_mode)) {
+        std::vector<char> link(static_cast<size_t>(st.st_size) + 1);
+        ssize_t len = ::readlink(src.constData(), link.data(), link.size());
+        if (len < 0)
+            return false;
+        link[static_cast<size_t>(len)] = '\0';
+        ok = ::symlink(link.data(), dst.constData()) == 0;
+        if (ok) {
+            struct timespec times[2] = { st.st_atim, st.st_mtim };
+            ::utimensat(AT_FDCWD, dst.constData(), times, AT_SYMLINK_NOFOLLOW);
+        }
+    } else if (S_ISREG(st.st_mode)) {
+        int in = ::open(src.constData(), O_RDONLY | O_CLOEXEC);
+        if (in < 0)
+            return false;
+        int out = ::open(dst.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 07777);
+        if (out < 0) {
+            int err = errno;
+            ::close(in);
+            errno = err;
+            return false;
+        }
+        ok = copyFileData(in, out, st.st_size);
+        if (ok) {
+            struct timespec times[2] = { st.st_atim, st.st_mtim };
+            ::futimens(out, times);
+        }
+        ::close(out);
+        ::close(in);
+        if (!ok)
+            ::unlink(dst.constData());
+    } else {
+        // fifos, sockets and device nodes are not copied, keep the source
+        errno = ENOTSUP;
+        return false;
+    }
+
+    if (ok && removeSource) {
+        if (S_ISDIR(st.st_mode))
+            QDir(QFile::decodeName(src)).removeRecursively();
+        else
+            ::unlink(src.constData());
+    }
+    return ok;
+}
 
 SettingHelper::SettingHelper()
     : QObject()
@@ -53,8 +208,9 @@ QJsonObject SettingHelper::ParseJson(const QString &filepath)
     return jsonObj;
 }
 
-bool SettingHelper::handleDataConfiguration(const QString &filepath)
+bool SettingHelper::handleDataConfiguration(const QString &filepath, bool filesPlaced)
 {
+    configuring = true;
     addTaskcounter(1);
     QJsonObject jsonObj = ParseJson(filepath + "/" + "transfer.json");
     if (jsonObj.isEmpty()) {
@@ -65,7 +221,8 @@ bool SettingHelper::handleDataConfiguration(const QString &filepath)
     }
 
     //Configure file
-    setFile(jsonObj, filepath);
+    if (!filesPlaced)
+        setFile(jsonObj, filepath);
 
     // Configure desktop wallpaper
     QString image = filepath + "/" + jsonObj["wallpapers"].toString();
@@ -76,14 +233,13 @@ bool SettingHelper::handleDataConfiguration(const QString &filepath)
     if (!jsonObj["browserbookmark"].toString().isEmpty())
         setBrowserBookMark(filepath + "/" + jsonObj["browserbookmark"].toString());
 
-    //installApps
-    QJsonValue userFileValue = jsonObj["app"];
-    if (userFileValue.isArray()) {
-        const QJsonArray &userFileArray = userFileValue.toArray();
-        for (const auto &value : userFileArray) {
-            installApps(value.toString());
-        }
-    }
+    //installApps, usually already started when transfer.json arrived
+    QStringList apps;
+    for (const auto &value : jsonObj["app"].toArray())
+        apps.append(value.toString());
+    installApps(apps);
+    if (!installJobs.isEmpty())
+        emit TransferHelper::instance()->transferContent(tr("Installing"), installJobs.constBegin().value(), 99, -2);
     addTaskcounter(-1);
     //remove dir
     QDir(filepath).removeRecursively();
@@ -147,97 +303,123 @@ bool SettingHelper::setBrowserBookMark(const QString &filepath)
     return true;
 }
 
-bool SettingHelper::installApps(const QString &app)
+void SettingHelper::installApps(const QStringList &apps)
 {
-    if (app.isEmpty())
-        return true;
-
-    QString &package = applist[app];
-    if (package.isEmpty()) {
-        emit TransferHelper::instance()->addResult(app, false, tr("Installation failed, please go to the app store to install"));
-        return false;
+    QStringList pendingApps;
+    for (const QString &app : apps) {
+        if (app.isEmpty() || requestedApps.contains(app))
+            continue;
+        requestedApps.insert(app);
+        if (applist.value(app).isEmpty()) {
+            emit TransferHelper::instance()->addResult(app, false, tr("Installation failed, please go to the app store to install"));
+            continue;
+        }
+        pendingApps.append(app);
     }
+    if (pendingApps.isEmpty())
+        return;
 
-    LOG << "Installing " << app.toStdString() << package.toStdString();
+    //Check if installed, the replies are handled in onPackageExists so the
+    //caller (often in the middle of a transfer) is never blocked
+    for (const QString &app : pendingApps) {
+        addTaskcounter(1);
+        callLastore("PackageExists", { applist.value(app) }, app, SLOT(onPackageExists(QDBusPendingCallWatcher *)));
+    }
+}
 
-    QString service = "com.deepin.lastore";
-    QString path = "/com/deepin/lastore";
-    QString interfaceName = "com.deepin.lastore.Manager";
+void SettingHelper::resetRequestedApps()
+{
+    // apps whose lastore job is still running stay requested
+    requestedApps.clear();
+    for (const QString &app : installJobs)
+        requestedApps.insert(app);
+}
 
-    QDBusInterface interface(service, path, interfaceName, QDBusConnection::systemBus());
+void SettingHelper::callLastore(const QString &method, const QVariantList &args, const QString &app, const char *slot)
+{
+    // 不用 QDBusInterface，它构造时会同步 introspect
+    QDBusMessage msg = QDBusMessage::createMethodCall(kLastoreService, "/com/deepin/lastore",
+                                                      "com.deepin.lastore.Manager", method);
+    msg.setArguments(args);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(msg), this);
+    watcher->setProperty("app", app);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher *)), this, slot);
+}
 
-    //Check if installed
-    QString existfunc = "PackageExists";
-    QDBusMessage existReply = interface.call(existfunc, package);
-    if (existReply.type() == QDBusMessage::ReplyMessage) {
-        bool isExist = existReply.arguments().at(0).toBool();
-        if (isExist) {
-            WLOG << app.toStdString() << "is installed";
-            emit TransferHelper::instance()->addResult(app, true, tr("is installed"));
-            return true;
-        }
+void SettingHelper::onPackageExists(QDBusPendingCallWatcher *watcher)
+{
+    watcher->deleteLater();
+    const QString app = watcher->property("app").toString();
+    QDBusPendingReply<bool> reply = *watcher;
+    if (reply.isValid() && reply.value()) {
+        WLOG << app.toStdString() << "is installed";
+        emit TransferHelper::instance()->addResult(app, true, tr("is installed"));
+        addTaskcounter(-1);
+        return;
     }
 
     //installed
-    QString func = "InstallPackage";
-
-    QDBusMessage reply = interface.call(func, QString(), package);
+    LOG << "Installing " << app.toStdString() << applist.value(app).toStdString();
+    callLastore("InstallPackage", { QString(), applist.value(app) }, app, SLOT(onInstallPackage(QDBusPendingCallWatcher *)));
+}
 
-    if (reply.type() != QDBusMessage::ReplyMessage) {
-        WLOG << "Installing " << app.toStdString() << "false" << reply.errorMessage().toStdString();
+void SettingHelper::onInstallPackage(QDBusPendingCallWatcher *watcher)
+{
+    watcher->deleteLater();
+    const QString app = watcher->property("app").toString();
+    QDBusPendingReply<QDBusObjectPath> reply = *watcher;
+    if (reply.isError()) {
+        WLOG << "Installing " << app.toStdString() << "false" << reply.error().message().toStdString();
         emit TransferHelper::instance()->addResult(app, false, tr("Installation failed, please go to the app store to install"));
-        return false;
+        requestedApps.remove(app);
+        addTaskcounter(-1);
+        return;
     }
 
-    QString jobPath = reply.arguments().at(0).value<QDBusObjectPath>().path();
+    // the task taken in installApps is released by onPropertiesChanged
+    const QString jobPath = reply.value().path();
     LOG << "Installing " << app.toStdString() << "true" << jobPath.toStdString();
-
-    bool success = QDBusConnection::systemBus().connect(service, jobPath, "org.freedesktop.DBus.Properties",
+    installJobs.insert(jobPath, app);
+    bool success = QDBusConnection::systemBus().connect(kLastoreService, jobPath, "org.freedesktop.DBus.Properties",
                                                         "PropertiesChanged", this, SLOT(onPropertiesChanged(QDBusMessage)));
     if (!success)
         WLOG << "Failed to connect to signal";
 
-    emit TransferHelper::instance()->transferContent(tr("Installing"), app, 99, -2);
-
-    addTaskcounter(1);
-    return true;
+    if (configuring)
+        emit TransferHelper::instance()->transferContent(tr("Installing"), app, 99, -2);
 }
 
 void SettingHelper::onPropertiesChanged(const QDBusMessage &message)
 {
     if (message.arguments().count() != 3)
         return;
+    const QString app = installJobs.value(message.path());
+    if (app.isEmpty())
+        return;
+
     QVariantMap changedProps = qdbus_cast<QVariantMap>(message.arguments().at(1).value<QDBusArgument>());
     foreach (const QString &key, changedProps.keys()) {
         QVariant value = changedProps.value(key);
-        QDBusInterface interface("com.deepin.lastore",
-                                 message.path(),
-                                 "com.deepin.lastore.Job",
-                                 QDBusConnection::systemBus());
-        auto packages = interface.property("Packages").toStringList();
-        QString package;
-        if (!packages.isEmpty())
-            package = packages.first();
-        QString app = applist.key(package);
-        QString content = applist.key(package) + "  Key:" + key + "   Value:" + value.toString();
-
-        //        if (key == "Progress") {
-        //            float floatValue = value.toString().trimmed().toFloat();
-        //            int percentageValue = qRound(floatValue * 100);
-        //            QString progress = QString(tr("Installing Progress %1 %").arg(percentageValue));
-        //            emit TransferHelper::instance()->transferContent(progress, app, 99, -2);
-        //        }
-
+        QString content = app + "  Key:" + key + "   Value:" + value.toString();
         LOG << "Installing " << content.toStdString();
 
-        if (key == "Status" && value == "succeed") {
+        // a cancelled job ends without succeeding
+        if (key != "Status" || (value != "succeed" && value != "failed" && value != "end"))
+            continue;
+
+        if (value == "succeed") {
             emit TransferHelper::instance()->addResult(app, true, tr("Transfer completed"));
-            addTaskcounter(-1);
-        }
-        if (key == "Status" && value == "failed") {
+        } else {
             emit TransferHelper::instance()->addResult(app, false, tr("Installation failed, please go to the app store to install"));
-            addTaskcounter(-1);
+            // the app can be requested again
+            requestedApps.remove(app);
         }
+
+        installJobs.remove(message.path());
+        QDBusConnection::systemBus().disconnect(kLastoreService, message.path(), "org.freedesktop.DBus.Properties",
+                                                "PropertiesChanged", this, SLOT(onPropertiesChanged(QDBusMessage)));
+        addTaskcounter(-1);
+        return;
     }
 }
 
@@ -245,7 +427,9 @@ void SettingHelper::addTaskcounter(int value)
 {
     taskcounter += value;
 
-    if (taskcounter == 0) {
+    if (taskcounter == 0 && configuring) {
+        configuring = false;
+        requestedApps.clear();
         emit TransferHelper::instance()->transferContent("", tr("Transfer Complete"), 100, -1);
         emit TransferHelper::instance()->transferFinished();
     }
@@ -254,54 +438,100 @@ void SettingHelper::addTaskcounter(int value)
 bool SettingHelper::setFile(QJsonObject jsonObj, QString filepath)
 {
     QJsonValue userFileValue = jsonObj["user_file"];
-    if (userFileValue.isArray()) {
-        const QJsonArray &userFileArray = userFileValue.toArray();
-        for (const auto &value : userFileArray) {
-            QString filename = value.toString();
-            QString targetFile = QDir::homePath() + "/" + filename;
-            QString file = filepath + filename.mid(filename.indexOf('/'));
-            QFileInfo info = QFileInfo(targetFile);
-            auto dir = info.dir();
-            if (!dir.exists())
-                dir.mkpath(".");
-            bool res = moveFile(file, targetFile);
-            QString des = res ? tr("Transfer completed") : tr("Transfer failed");
-            emit TransferHelper::instance()->addResult(info.fileName(), res, des);
-        }
+    if (!userFileValue.isArray())
+        return true;
+
+    // Every user_file entry is a whole selected file or folder, so a single
+    // rename moves its subtree. Parent dirs are created once, then the
+    // independent entries are placed concurrently.
+    using Move = QPair<QString, QString>;
+    QList<Move> moves;
+    QSet<QString> parents;
+    const QJsonArray &userFileArray = userFileValue.toArray();
+    for (const auto &value : userFileArray) {
+        QString filename = value.toString();
+        QString targetFile = QDir::homePath() + "/" + filename;
+        QString file = filepath + filename.mid(filename.indexOf('/'));
+        parents.insert(QFileInfo(targetFile).path());
+        moves.append({ file, targetFile });
     }
-    LOG << jsonObj["user_file"].toString().toStdString();
-    return true;
+
+    QDir dir;
+    for (const QString &parent : parents)
+        dir.mkpath(parent);
+
+    const std::function<bool(const Move &)> place = [](const Move &move) {
+        QString dst = move.second;
+        return moveFile(move.first, dst);
+    };
+    const QList<bool> results = QtConcurrent::blockingMapped<QList<bool>>(moves, place);
+
+    QStringList succeeded, failed;
+    for (int i = 0; i < moves.size(); ++i)
+        (results.at(i) ? succeeded : failed).append(QFileInfo(moves.at(i).second).fileName());
+    if (!succeeded.isEmpty())
+        emit TransferHelper::instance()->addResults(succeeded, true, tr("Transfer completed"));
+    if (!failed.isEmpty())
+        emit TransferHelper::instance()->addResults(failed, false, tr("Transfer failed"));
+
+    LOG << "place user files, succeeded:" << succeeded.size() << " failed:" << failed.size();
+    return failed.isEmpty();
 }
 
 bool SettingHelper::moveFile(const QString &src, QString &dst)
 {
-    if (QFile::exists(dst)) {
-        int i = 1;
-        QString fileName = dst.split("/").last();
-        QString dstDir = dst.remove(fileName);
-        QStringList filenamelist = fileName.split(".");
-        QString suffix;
-        if (!QFileInfo(src).isDir() && filenamelist.size() >= 2) {
-            suffix = filenamelist.last();
-            suffix = "." + suffix;
-        }
-        QString baseName = fileName;
-        baseName = fileName.remove(suffix);
-
-        while (QFile::exists(dst)) {
-            dst = dstDir + "/" + baseName + "(" + QString::number(i) + ")" + suffix;
-            i++;
+    const QByteArray srcPath = QFile::encodeName(src);
+    struct stat st;
+    if (::lstat(srcPath.constData(), &st) != 0) {
+        WLOG << "moveFile error: " << src.toStdString() << " " << strerror(errno);
+        return false;
+    }
+    const bool isDir = S_ISDIR(st.st_mode);
+
+    // Conflicts are detected by the kernel instead of probing with exists(),
+    // the next numbered name is only tried when the target is taken.
+    const QString origin = dst;
+    for (int i = 1; i <= kMaxNameIndex; ++i) {
+        const QByteArray dstPath = QFile::encodeName(dst);
+        int ret = renameNoReplace(srcPath.constData(), dstPath.constData());
+        if (ret != 0 && errno == EXDEV)
+            ret = copyPath(srcPath, dstPath, true) ? 0 : -1;
+
+        if (ret == 0) {
+            LOG << "moveFile dst: " << src.toStdString() << "   " << dst.toStdString();
+            return true;
         }
+        if (errno != EEXIST)
+            break;
+        dst = numberedPath(origin, isDir, i);
     }
-    QFile f(src);
-    LOG << "moveFile dst: " << src.toStdString() << "   " << dst.toStdString();
-    if (f.rename(dst))
-        return true;
 
-    WLOG << "moveFile error: " << f.errorString().toStdString();
+    WLOG << "moveFile error: " << src.toStdString() << " -> " << dst.toStdString() << " " << strerror(errno);
     return false;
 }
 
+QString SettingHelper::availablePath(const QString &path, bool isDir)
+{
+    QString dst = path;
+    for (int i = 1; QFile::exists(dst); ++i)
+        dst = numberedPath(path, isDir, i);
+    return dst;
+}
+
+QString SettingHelper::numberedPath(const QString &path, bool isDir, int index)
+{
+    const int slash = path.lastIndexOf('/');
+    const QString dstDir = path.left(slash + 1);
+    QString baseName = path.mid(slash + 1);
+    QString suffix;
+    const int dot = baseName.lastIndexOf('.');
+    if (!isDir && dot > 0) {
+        suffix = baseName.mid(dot);
+        baseName.truncate(dot);
+    }
+    return dstDir + baseName + "(" + QString::number(index) + ")" + suffix;
+}
+
 void SettingHelper::initAppList()
 {
     QJsonObject jsonObj = ParseJson(":/fileResource/apps.json");
@@ -1,11 +1,15 @@
 ﻿#ifndef SETTINGHELPER_H
 #define SETTINGHELPER_H
 
+#include <QHash>
 #include <QMap>
 #include <QObject>
+#include <QSet>
 #include <QDBusMessage>
 #include <QUrl>
 
+class QDBusPendingCallWatcher;
+
 class SettingHelper : public QObject
 {
     Q_OBJECT
@@ -18,12 +22,17 @@ public:
 
     static QJsonObject ParseJson(const QString &filepath);
     static bool moveFile(const QString &src, QString &dst);
+    static QString availablePath(const QString &path, bool isDir);
+    static QString numberedPath(const QString &path, bool isDir, int index);
 
 public:
-    bool handleDataConfiguration(const QString &filepath);
+    // filesPlaced: user files have already been written to their final destinations
+    bool handleDataConfiguration(const QString &filepath, bool filesPlaced = false);
     bool setWallpaper(const QString &filepath);
     bool setBrowserBookMark(const QString &filepath);
-    bool installApps(const QString &app);
+    void installApps(const QStringList &apps);
+    // A new transfer may request the same apps again
+    void resetRequestedApps();
     bool setFile(QJsonObject jsonObj, QString filepath);
 
     void addTaskcounter(int value);
@@ -31,8 +40,13 @@ public:
 public Q_SLOTS:
     void onPropertiesChanged(const QDBusMessage &message);
 
+private Q_SLOTS:
+    void onPackageExists(QDBusPendingCallWatcher *watcher);
+    void onInstallPackage(QDBusPendingCallWatcher *watcher);
+
 private:
     void initAppList();
+    void callLastore(const QString &method, const QVariantList &args, const QString &app, const char *slot);
 
 private:
     //用于统计开启了多少个配置任务。
@@ -40,6 +54,14 @@ private:
 
     //App and package list
     QMap<QString, QString> applist;
+
+    // Set while the received data is being configured, the job only
+    // finishes once every task is done
+    bool configuring = false;
+    // Apps already handed to lastore, installs can start before the files arrive
+    QSet<QString> requestedApps;
+    // lastore job path -> app
+    QHash<QString, QString> installJobs;
 };
 
 #endif
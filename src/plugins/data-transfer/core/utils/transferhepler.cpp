@@ -40,6 +40,13 @@ TransferHelper::TransferHelper()
 #ifndef WIN32
     SettingHelper::instance();
     connect(this, &TransferHelper::transferFinished, this, [this]() { isSetting = false; });
+    connect(this, &TransferHelper::interruption, this, &TransferHelper::saveUnfinishedJob);
+    connect(this, &TransferHelper::transferFinished, this, [this] {
+        if (!journal.isOpen())
+            return;
+        journal.remove();
+        QFile::remove(tempJsonPath());
+    });
 #endif
 }
 
@@ -372,87 +379,97 @@ void TransferHelper::recordTranferJob(const QString &filepath)
 {
     // 1.copy transferjson to temp
     QFile jsonfile(filepath);
-    QFileInfo info(jsonfile);
-    QString tempPath(tempCacheDir() + connectIP + "transfer-temp.json");
+    QString tempPath = tempJsonPath();
     QFile tempfile(tempPath);
     if (tempfile.exists())
         tempfile.remove();
     if (!jsonfile.copy(tempPath))
         WLOG << "Failed to copy recordTranfer file" + tempPath.toStdString();
 
-    connect(this, &TransferHelper::interruption, this, [this, filepath, tempPath]() {
-        // 2.write unfinished files to tempjson file
-        QJsonObject jsonObj = SettingHelper::ParseJson(filepath);
-        QFile jsonfile(filepath);
-        QString fileDir = filepath.left(filepath.lastIndexOf('/'));
-        if (!jsonfile.exists() || jsonObj.isEmpty()) {
-            WLOG << "Failed to recordTranfer file";
-            return;
-        }
-        QJsonArray userFileArray = jsonObj["user_file"].toArray();
-        QJsonArray updatedFileList;
-        bool ok;
-        int64 userData = jsonObj["user_data"].toString().toLongLong(&ok);
-
-        LOG << "finshedFiles-----" << finshedFiles.size();
-
-        foreach (const QJsonValue &fileValue, userFileArray) {
-            QString file = fileValue.toString();
-            QString filename = file.mid(file.indexOf('/'));
-
-            // skip finished files
-            bool isend = false;
-            for (QString key : finshedFiles.keys()) {
-                if (key.endsWith(filename)) {
-                    isend = true;
-                    if (ok)
-                        userData -= finshedFiles.value(key);
-                    finshedFiles.remove(key);
-                    break;
-                }
-            }
-            if (isend) {
-                //Move completed files first
-                QString targetFile = QDir::homePath() + "/" + file;
-                QString originfile = fileDir + filename;
-                QFileInfo info = QFileInfo(targetFile);
-                auto dir = info.dir();
-                if (!dir.exists())
-                    dir.mkpath(".");
-                SettingHelper::instance()->moveFile(originfile, targetFile);
-                continue;
-            }
-
-            updatedFileList.append(file);
-        }
-        // 3.save unfinished filelist for retransmission
-        jsonObj["user_file"] = updatedFileList;
-        if (ok)
-            jsonObj["user_data"] = QString::number(userData);
-        QJsonDocument jsonDoc;
-        jsonDoc.setObject(jsonObj);
-        QFile tempfile(tempPath);
-        if (!tempfile.open(QIODevice::WriteOnly | QIODevice::Truncate))
-            WLOG << "Failed to open JSON file for writing";
-        tempfile.write(jsonDoc.toJson());
-        tempfile.close();
-        // remove transfer dir
-        QDir dir(fileDir);
-        if (!dir.removeRecursively()) {
-            WLOG << "Failed to remove directory";
+    // 2.journal every received file, the unfinished list is rebuilt from it
+    // after an interruption or a crash
+    journal.create(journalPath(), filepath.left(filepath.lastIndexOf('/')));
+
+    // 3.install the apps while the files are still being received
+    QStringList apps;
+    for (const auto &value : SettingHelper::ParseJson(filepath)["app"].toArray())
+        apps.append(value.toString());
+    SettingHelper::instance()->resetRequestedApps();
+    SettingHelper::instance()->installApps(apps);
+}
+
+void TransferHelper::saveUnfinishedJob()
+{
+    if (!journal.isOpen())
+        return;
+    journal.sync();
+
+    // 3.write unfinished files to tempjson file
+    QString tempPath = tempJsonPath();
+    QJsonObject jsonObj = SettingHelper::ParseJson(tempPath);
+    QString fileDir = journal.jobDir();
+    if (jsonObj.isEmpty()) {
+        WLOG << "Failed to recordTranfer file";
+        journal.remove();
+        return;
+    }
+    QJsonArray userFileArray = jsonObj["user_file"].toArray();
+    QJsonArray updatedFileList;
+    bool ok;
+    int64 userData = jsonObj["user_data"].toString().toLongLong(&ok);
+
+    const QHash<QString, qint64> &finshedFiles = journal.entries();
+    LOG << "finshedFiles-----" << finshedFiles.size();
+
+    foreach (const QJsonValue &fileValue, userFileArray) {
+        QString file = fileValue.toString();
+        QString filename = file.mid(file.indexOf('/'));
+
+        // skip finished files
+        auto it = finshedFiles.constFind(filename);
+        if (it != finshedFiles.constEnd()) {
+            if (ok)
+                userData -= it.value();
+            //Move completed files first
+            QString targetFile = QDir::homePath() + "/" + file;
+            QString originfile = fileDir + filename;
+            QFileInfo info = QFileInfo(targetFile);
+            auto dir = info.dir();
+            if (!dir.exists())
+                dir.mkpath(".");
+            SettingHelper::instance()->moveFile(originfile, targetFile);
+            continue;
         }
-    });
 
-    connect(this, &TransferHelper::transferFinished, this, [this, tempPath] {
-        finshedFiles.clear();
-        QFile tempfile(tempPath);
-        tempfile.remove(tempPath);
-    });
+        updatedFileList.append(file);
+    }
+    // 4.save unfinished filelist for retransmission
+    jsonObj["user_file"] = updatedFileList;
+    if (ok)
+        jsonObj["user_data"] = QString::number(userData);
+    QJsonDocument jsonDoc;
+    jsonDoc.setObject(jsonObj);
+    QFile tempfile(tempPath);
+    if (!tempfile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        WLOG << "Failed to open JSON file for writing";
+    tempfile.write(jsonDoc.toJson());
+    tempfile.close();
+    // remove transfer dir
+    QDir dir(fileDir);
+    if (!dir.removeRecursively()) {
+        WLOG << "Failed to remove directory";
+    }
+    journal.remove();
 }
 
 bool TransferHelper::isUnfinishedJob(QString &content)
 {
-    QString transtempPath(tempCacheDir() + connectIP + "transfer-temp.json");
+    // A journal left on disk means the previous job ended without handling
+    // the interruption, e.g. the app crashed
+    if (!journal.isOpen() && journal.load(journalPath()))
+        saveUnfinishedJob();
+
+    QString transtempPath = tempJsonPath();
     QFile f(transtempPath);
     if (!f.exists())
         return false;
@@ -470,9 +487,23 @@ bool TransferHelper::isUnfinishedJob(QString &content)
 
 void TransferHelper::addFinshedFiles(const QString &filepath, int64 size)
 {
-    finshedFiles.insert(filepath, size);
-    if (filepath.endsWith("transfer.json"))
+    if (filepath.endsWith("transfer.json")) {
         TransferHelper::instance()->recordTranferJob(filepath);
+        return;
+    }
+
+    const QString jobDir = journal.jobDir();
+    journal.append(filepath.startsWith(jobDir) ? filepath.mid(jobDir.length()) : filepath, size);
+}
+
+QString TransferHelper::tempJsonPath()
+{
+    return tempCacheDir() + connectIP + "transfer-temp.json";
+}
+
+QString TransferHelper::journalPath()
+{
+    return tempCacheDir() + connectIP + "transfer-journal";
 }
 
 void TransferHelper::setConnectIP(const QString &ip)
@@ -480,10 +511,10 @@ void TransferHelper::setConnectIP(const QString &ip)
     connectIP = ip;
 }
 
-void TransferHelper::setting(const QString &filepath)
+void TransferHelper::setting(const QString &filepath, bool filesPlaced)
 {
     isSetting = true;
-    SettingHelper::instance()->handleDataConfiguration(filepath);
+    SettingHelper::instance()->handleDataConfiguration(filepath, filesPlaced);
 }
 
 int TransferHelper::getRemainSize()
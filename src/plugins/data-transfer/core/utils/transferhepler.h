@@ -7,6 +7,7 @@
 #include <QObject>
 #include "../gui/type_defines.h"
 #ifndef WIN32
+#    include "transferjournal.h"
 #    include <QDBusMessage>
 #endif
 
@@ -52,14 +53,20 @@ public:
 public:
     static int getRemainSize();
     bool checkSize(const QString &filepath);
-    void setting(const QString &filepath);
+    void setting(const QString &filepath, bool filesPlaced = false);
     void recordTranferJob(const QString &filepath);
     bool isUnfinishedJob(QString &content);
     void addFinshedFiles(const QString &filepath, int64 size);
     void setConnectIP(const QString &ip);
 
 private:
-    QMap<QString, int64> finshedFiles;
+    void saveUnfinishedJob();
+    QString tempJsonPath();
+    QString journalPath();
+
+private:
+    // files received by the current job, used to resume it
+    TransferJournal journal;
     bool isSetting = false;
     QString connectIP;
 #endif
@@ -90,6 +97,7 @@ Q_SIGNALS:
 
     // display config failure
     void addResult(QString name, bool success, QString reason);
+    void addResults(const QStringList &names, bool success, const QString &reason);
 
     // Transmission interruption
     void interruption();
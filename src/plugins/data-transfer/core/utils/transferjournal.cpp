@@ -0,0 +1,121 @@
+#include "transferjournal.h"
+
+#include <co/log.h>
+
+#include <unistd.h>
+
+// Entries written before the journal is flushed to disk
+inline constexpr int kSyncBatch { 64 };
+inline constexpr int kSyncIntervalMs { 1000 };
+
+TransferJournal::~TransferJournal()
+{
+    close();
+}
+
+bool TransferJournal::create(const QString &path, const QString &jobDir)
+{
+    close();
+    index.clear();
+    dir = jobDir;
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        WLOG << "could not create transfer journal:" << path.toStdString();
+        return false;
+    }
+    file.write(jobDir.toUtf8() + '\n');
+    ::fdatasync(file.handle());
+    lastSync.start();
+    return true;
+}
+
+bool TransferJournal::load(const QString &path)
+{
+    close();
+    index.clear();
+    dir.clear();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QByteArray data = file.readAll();
+    file.close();
+
+    const QList<QByteArray> lines = data.split('\n');
+    // The last element is either empty or an incomplete line
+    for (int i = 0; i < lines.size() - 1; ++i) {
+        const QByteArray &line = lines.at(i);
+        if (i == 0) {
+            dir = QString::fromUtf8(line);
+            continue;
+        }
+        const int tab = line.indexOf('\t');
+        if (tab <= 0)
+            continue;
+        index.insert(QString::fromUtf8(line.mid(tab + 1)), line.left(tab).toLongLong());
+    }
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) {
+        WLOG << "could not open transfer journal:" << path.toStdString();
+        return false;
+    }
+    if (dir.isEmpty()) {
+        file.close();
+        return false;
+    }
+    lastSync.start();
+    LOG << "transfer journal loaded, finished files:" << index.size();
+    return true;
+}
+
+void TransferJournal::append(const QString &relativePath, qint64 size)
+{
+    if (!file.isOpen())
+        return;
+
+    index.insert(relativePath, size);
+    file.write(QByteArray::number(size) + '\t' + relativePath.toUtf8() + '\n');
+    if (++pending >= kSyncBatch || lastSync.elapsed() >= kSyncIntervalMs)
+        sync();
+}
+
+void TransferJournal::sync()
+{
+    if (!file.isOpen() || pending == 0)
+        return;
+    ::fdatasync(file.handle());
+    pending = 0;
+    lastSync.restart();
+}
+
+void TransferJournal::close()
+{
+    sync();
+    if (file.isOpen())
+        file.close();
+}
+
+void TransferJournal::remove()
+{
+    close();
+    index.clear();
+    dir.clear();
+    if (!file.fileName().isEmpty())
+        file.remove();
+}
+
+bool TransferJournal::isOpen() const
+{
+    return file.isOpen();
+}
+
+QString TransferJournal::jobDir() const
+{
+    return dir;
+}
+
+const QHash<QString, qint64> &TransferJournal::entries() const
+{
+    return index;
+}
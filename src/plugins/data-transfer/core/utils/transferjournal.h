@@ -0,0 +1,37 @@
+#ifndef TRANSFERJOURNAL_H
+#define TRANSFERJOURNAL_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+// Append-only record of the files received by the current transfer job.
+// Every line is "<size>\t<path relative to the job dir>", the first line
+// holds the job dir. A torn last line left by a crash is ignored on load.
+class TransferJournal
+{
+public:
+    TransferJournal() = default;
+    ~TransferJournal();
+
+    bool create(const QString &path, const QString &jobDir);
+    bool load(const QString &path);
+    void append(const QString &relativePath, qint64 size);
+    void sync();
+    void close();
+    void remove();
+
+    bool isOpen() const;
+    QString jobDir() const;
+    const QHash<QString, qint64> &entries() const;
+
+private:
+    QFile file;
+    QString dir;
+    QHash<QString, qint64> index;
+    int pending = 0;
+    QElapsedTimer lastSync;
+};
+
+#endif   // TRANSFERJOURNAL_H